@@ -0,0 +1,114 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines block- and streaming-based interfaces for
+ *      base32 encoding and decoding.
+ *
+ */
+
+#ifndef NLUTILITIES_NLBASE32_H
+#define NLUTILITIES_NLBASE32_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Alphabet, case and padding flags. NLBASE32_FLAG_HEX selects the
+ * "extended hex" alphabet of RFC 4648, section 7, which preserves the
+ * sort order of the encoded data, in place of the standard alphabet of
+ * section 6, for both encoding and decoding. NLBASE32_FLAG_LOWER_CASE
+ * encodes in lower case; decoding always accepts either case.
+ * NLBASE32_FLAG_NO_PADDING omits the trailing '=' when encoding; padding
+ * is always optional when decoding.
+ */
+
+#define NLBASE32_FLAG_LOWER_CASE 0x1
+#define NLBASE32_FLAG_NO_PADDING 0x2
+#define NLBASE32_FLAG_HEX        0x4
+
+/* Block Base32 encoder and decoder for inputs of any size. The decoder
+ * returns SIZE_MAX on error.
+ */
+
+extern size_t nl_base32_decode(const char *in, size_t inLen, uint8_t *out, uint8_t flags);
+extern size_t nl_base32_encode(const uint8_t *in, size_t inLen, char *out, uint8_t flags);
+
+extern size_t nl_base32_decoded_len(const char *in, size_t inLen);
+extern size_t nl_base32_encoded_len(size_t inLen, bool pad);
+
+/* Streaming Base32 encoder for inputs of any size. Output goes a block
+ * at a time to a write function. nl_base32_stream_enc_more returns the
+ * number of characters written by that call and nl_base32_stream_enc_finish
+ * the total.
+ */
+
+typedef void (*nl_base32_stream_enc_write_t)(const char *inChars, size_t inLen, void *inContext);
+
+typedef struct {
+    uint8_t                      encoded[5];
+    uint8_t                      num_encoded;
+    uint8_t                      flags;
+    uint64_t                     num_written;
+    nl_base32_stream_enc_write_t write;
+    void *                       context;
+} nl_base32_stream_enc_state_t;
+
+extern void     nl_base32_stream_enc_start(nl_base32_stream_enc_state_t *state, uint8_t flags,
+                                           nl_base32_stream_enc_write_t out_write,
+                                           void *context);
+extern uint64_t nl_base32_stream_enc_more(const uint8_t *in, size_t inLen,
+                                          nl_base32_stream_enc_state_t *state);
+extern uint64_t nl_base32_stream_enc_finish(nl_base32_stream_enc_state_t *state);
+
+/* Streaming Base32 decoder. Requires only O(1) state, accepts fragments
+ * split at any point, and writes decoded bytes either to a caller buffer
+ * or, block by block, to a write function.
+ */
+
+typedef void (*nl_base32_stream_dec_write_t)(const uint8_t *inBytes, size_t inLen, void *inContext);
+
+typedef struct {
+    uint32_t                     bits;
+    uint8_t                      num_bits;
+    uint8_t                      num_decoded;
+    uint8_t                      flags;
+    bool                         done;
+    bool                         error;
+    uint64_t                     num_written;
+    nl_base32_stream_dec_write_t write;
+    void *                       context;
+} nl_base32_stream_dec_state_t;
+
+extern void     nl_base32_stream_dec_start(nl_base32_stream_dec_state_t *state, uint8_t flags,
+                                           nl_base32_stream_dec_write_t out_write,
+                                           void *context);
+extern size_t   nl_base32_stream_dec_more(const char *in, size_t inLen, uint8_t *out,
+                                          nl_base32_stream_dec_state_t *state);
+extern uint64_t nl_base32_stream_dec_finish(nl_base32_stream_dec_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NLUTILITIES_NLBASE32_H
@@ -37,6 +37,91 @@ extern "C" {
 extern uint16_t nl_base64_decode(const char *in, uint16_t inLen, uint8_t *out);
 extern uint16_t nl_base64_encode(const uint8_t *in, uint16_t inLen, char *out);
 
+/* Block Base64 encoder and decoder for inputs of any size. The decoder
+ * returns SIZE_MAX on error.
+ */
+
+extern size_t nl_base64_decode_ex(const char *in, size_t inLen, uint8_t *out);
+extern size_t nl_base64_encode_ex(const uint8_t *in, size_t inLen, char *out);
+
+/* Alphabet and padding flags. NLBASE64_FLAG_URL_SAFE selects the URL-
+ * and filename-safe alphabet of RFC 4648, with '-' and '_' in place of
+ * '+' and '/', for encoding, and accepts either alphabet for decoding.
+ * NLBASE64_FLAG_NO_PADDING omits the trailing '=' when encoding; padding
+ * is always optional when decoding.
+ */
+
+#define NLBASE64_FLAG_URL_SAFE   0x1
+#define NLBASE64_FLAG_NO_PADDING 0x2
+
+extern size_t nl_base64_decode_flags(const char *in, size_t inLen, uint8_t *out, uint8_t flags);
+extern size_t nl_base64_encode_flags(const uint8_t *in, size_t inLen, char *out, uint8_t flags);
+
+/* Block Base64 encoder for input gathered from several non-contiguous
+ * segments, such as a header, body, and trailer. The output is that of
+ * encoding their concatenation, produced without copying them together.
+ */
+
+typedef struct {
+    const void *data;
+    size_t      length;
+} nl_base64_segment_t;
+
+extern size_t nl_base64_encode_segments(const nl_base64_segment_t *segments, size_t num_segments,
+                                        char *out, uint8_t flags);
+
+/* Block Base64 encoder that encodes the inLen bytes at the start of a
+ * buffer in place, with no second buffer and no move afterwards. The
+ * buffer must be nl_base64_encoded_len(inLen, pad) bytes long, where
+ * pad reflects NLBASE64_FLAG_NO_PADDING in flags.
+ */
+
+extern size_t nl_base64_encode_in_place(uint8_t *inOut, size_t inLen, uint8_t flags);
+
+/* Validate a Base64 string without decoding it. Returns the number of
+ * bytes nl_base64_decode_flags would decode from it, or SIZE_MAX if it
+ * would fail, without writing any output.
+ */
+
+extern size_t nl_base64_validate(const char *in, size_t inLen, uint8_t flags);
+
+/* Block Base64 decoder that also folds the decoded bytes into a CRC
+ * computed by crc_update, such as nl_crc32 or nl_crc32c of nlcrc32.h,
+ * a cache-sized block at a time, while the bytes just written are still
+ * in cache. The CRC continues from, and on success is stored back to,
+ * *crc. Returns SIZE_MAX on error.
+ */
+
+typedef uint32_t (*nl_base64_crc_update_t)(uint32_t inCrc, const void *inBytes, size_t inLen);
+
+extern size_t nl_base64_decode_crc(const char *in, size_t inLen, uint8_t *out, uint8_t flags,
+                                   nl_base64_crc_update_t crc_update, uint32_t *crc);
+
+/* Block Base64 decoder for PEM and MIME bodies that skips whitespace,
+ * including line breaks, anywhere in the input. The output must have
+ * room for inLen * 3 / 4 bytes. Returns SIZE_MAX on error.
+ */
+
+extern size_t nl_base64_decode_ws(const char *in, size_t inLen, uint8_t *out);
+
+/* Block Base64 encoder for PEM and MIME bodies that ends every line of
+ * line_length characters, and the last line, with the null-terminated
+ * terminator, such as "\n" or "\r\n". A line_length of 0 disables
+ * wrapping.
+ */
+
+extern size_t nl_base64_encode_lines(const uint8_t *in, size_t inLen, char *out,
+                                     size_t line_length, const char *terminator);
+
+/* Exact output lengths, for sizing buffers ahead of time. Neither
+ * includes a null terminator.
+ */
+
+extern size_t nl_base64_decoded_len(const char *in, size_t inLen);
+extern size_t nl_base64_encoded_len(size_t inLen, bool pad);
+extern size_t nl_base64_encoded_lines_len(size_t inLen, size_t line_length,
+                                          size_t terminator_length);
+
 /* Streaming Base64 encoder. Requires only 4 bytes on the stack rather
  * than an O(N) output buffer.
  */
@@ -59,6 +144,113 @@ extern uint16_t nl_base64_stream_enc_more(const uint8_t *in, uint16_t inLen,
 extern uint16_t nl_base64_stream_enc_finish(bool pad,
                                             nl_base64_stream_enc_state_t *state);
 
+/* Streaming Base64 encoder for inputs of any size, with 64-bit counters.
+ * Output goes either a character at a time to a putchar function or, via
+ * a caller-supplied staging buffer of at least 4 characters, a block at a
+ * time to a write function. Once started, the encoder may be set to use
+ * the URL-safe alphabet or to wrap its output into lines, as
+ * nl_base64_encode_lines does.
+ */
+
+typedef void (*nl_base64_stream_enc_write_t)(const char *inChars, size_t inLen, void *inContext);
+
+typedef struct {
+    uint8_t                        encoded[3];
+    uint8_t                        num_encoded;
+    uint64_t                       num_written;
+    nl_base64_stream_enc_putchar_t putchar;
+    nl_base64_stream_enc_write_t   write;
+    char *                         buffer;
+    size_t                         buffer_size;
+    size_t                         buffered;
+    size_t                         line_length;
+    size_t                         column;
+    const char *                   terminator;
+    size_t                         terminator_length;
+    bool                           url_safe;
+    void *                         context;
+} nl_base64_stream_enc_ex_state_t;
+
+extern void     nl_base64_stream_enc_ex_start(nl_base64_stream_enc_ex_state_t *state,
+                                              nl_base64_stream_enc_putchar_t out_putchar,
+                                              void *context);
+extern void     nl_base64_stream_enc_ex_start_buffered(nl_base64_stream_enc_ex_state_t *state,
+                                                       char *buffer, size_t buffer_size,
+                                                       nl_base64_stream_enc_write_t out_write,
+                                                       void *context);
+extern void     nl_base64_stream_enc_ex_set_flags(nl_base64_stream_enc_ex_state_t *state,
+                                                  uint8_t flags);
+extern void     nl_base64_stream_enc_ex_set_lines(nl_base64_stream_enc_ex_state_t *state,
+                                                  size_t line_length, const char *terminator);
+extern uint64_t nl_base64_stream_enc_ex_more(const uint8_t *in, size_t inLen,
+                                             nl_base64_stream_enc_ex_state_t *state);
+extern uint64_t nl_base64_stream_enc_ex_finish(bool pad,
+                                               nl_base64_stream_enc_ex_state_t *state);
+
+/* Streaming Base64 decoder. Requires only O(1) state, accepts fragments
+ * split at any point, and writes decoded bytes either to a caller buffer
+ * or, block by block, to a write function. When started with
+ * nl_base64_stream_dec_start_ws, whitespace and line breaks in the input
+ * are skipped. Once started, the decoder may be set to keep a running CRC
+ * of the decoded bytes in crc, as nl_base64_decode_crc does.
+ */
+
+typedef void (*nl_base64_stream_dec_write_t)(const uint8_t *inBytes, size_t inLen, void *inContext);
+
+typedef struct {
+    uint8_t                      last;
+    uint8_t                      num_decoded;
+    bool                         done;
+    bool                         error;
+    bool                         skip_whitespace;
+    bool                         url_safe;
+    size_t                       line_length;
+    size_t                       column;
+    uint64_t                     num_written;
+    nl_base64_crc_update_t       crc_update;
+    uint32_t                     crc;
+    nl_base64_stream_dec_write_t write;
+    void *                       context;
+} nl_base64_stream_dec_state_t;
+
+extern void     nl_base64_stream_dec_start(nl_base64_stream_dec_state_t *state,
+                                           nl_base64_stream_dec_write_t out_write,
+                                           void *context);
+extern void     nl_base64_stream_dec_start_ws(nl_base64_stream_dec_state_t *state,
+                                              nl_base64_stream_dec_write_t out_write,
+                                              void *context);
+extern void     nl_base64_stream_dec_set_flags(nl_base64_stream_dec_state_t *state,
+                                               uint8_t flags);
+extern void     nl_base64_stream_dec_set_crc(nl_base64_stream_dec_state_t *state,
+                                             nl_base64_crc_update_t crc_update, uint32_t crc);
+extern size_t   nl_base64_stream_dec_more(const char *in, size_t inLen, uint8_t *out,
+                                          nl_base64_stream_dec_state_t *state);
+extern uint64_t nl_base64_stream_dec_finish(nl_base64_stream_dec_state_t *state);
+
+/* Parallel Base64 encoder and decoder for very large buffers. The input
+ * is split on group boundaries into num_tasks chunks that are coded
+ * concurrently into disjoint ranges of the output, which is identical to
+ * that of nl_base64_encode_ex and nl_base64_decode_ex. Input and output
+ * must not overlap, and the decoder output must have room for
+ * nl_base64_decoded_len bytes.
+ *
+ * Chunks are run by the caller's run function, which must call
+ * task(i, task_context) once for each i in [0, num_tasks) on any thread
+ * and return only once all have completed. When run is NULL, a thread is
+ * created for each chunk (num_tasks of 0 uses one per online CPU).
+ */
+
+typedef void (*nl_base64_parallel_task_t)(size_t inIndex, void *inContext);
+typedef void (*nl_base64_parallel_run_t)(nl_base64_parallel_task_t inTask, void *inTaskContext,
+                                         size_t inNumTasks, void *inContext);
+
+extern size_t nl_base64_decode_parallel(const char *in, size_t inLen, uint8_t *out,
+                                        size_t num_tasks,
+                                        nl_base64_parallel_run_t run, void *context);
+extern size_t nl_base64_encode_parallel(const uint8_t *in, size_t inLen, char *out,
+                                        size_t num_tasks,
+                                        nl_base64_parallel_run_t run, void *context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,455 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements lazy C++ views that base64 encode or decode
+ *      a range a group at a time, as they are iterated, without
+ *      allocating any intermediate buffer.
+ *
+ */
+
+#ifndef NLUTILITIES_NLBASE64_HPP
+#define NLUTILITIES_NLBASE64_HPP
+
+#if __cplusplus >= 201103L
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <iterator>
+
+#include <nlbase64.h>
+
+namespace nl
+{
+
+/*
+ *  class base64_encode_view<>
+ *
+ *  Description:
+ *    This class template presents the bytes of the range
+ *    [inFirst, inLast) as the characters of their base64 encoding,
+ *    with the alphabet and padding selected by the NLBASE64_FLAG_*
+ *    flags. Its iterators are input iterators that read and encode
+ *    up to 48 bytes of the range at a time, so the encoding may be
+ *    passed directly to std::copy or any other algorithm.
+ *
+ *  Parameter(s):
+ *    _Iterator - The type of an input iterator over the bytes to
+ *                encode.
+ *
+ */
+template <typename _Iterator>
+class base64_encode_view
+{
+public:
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef char                    value_type;
+        typedef ptrdiff_t               difference_type;
+        typedef const char *            pointer;
+        typedef const char &            reference;
+
+        iterator(void) :
+            mCurrent(),
+            mLast(),
+            mFlags(0),
+            mIndex(0),
+            mLength(0)
+        {
+            return;
+        }
+
+        iterator(_Iterator inFirst, _Iterator inLast, uint8_t inFlags) :
+            mCurrent(inFirst),
+            mLast(inLast),
+            mFlags(inFlags),
+            mIndex(0),
+            mLength(0)
+        {
+            Fill();
+        }
+
+        reference operator *(void) const
+        {
+            return mChars[mIndex];
+        }
+
+        pointer operator ->(void) const
+        {
+            return &mChars[mIndex];
+        }
+
+        iterator &operator ++(void)
+        {
+            if (++mIndex == mLength)
+                Fill();
+
+            return *this;
+        }
+
+        iterator operator ++(int)
+        {
+            iterator theResult(*this);
+
+            ++*this;
+
+            return theResult;
+        }
+
+        bool operator ==(const iterator &inOther) const
+        {
+            return (mCurrent == inOther.mCurrent) &&
+                   (mLength - mIndex == inOther.mLength - inOther.mIndex);
+        }
+
+        bool operator !=(const iterator &inOther) const
+        {
+            return !(*this == inOther);
+        }
+
+    private:
+        // Encode the next 16 groups, or as many as remain, so that the
+        // block encoder runs over more than one group per call. Fewer
+        // than 48 bytes are read only at the end of the range, where the
+        // last group is padded. The iterator is left equal to the end
+        // iterator once the range is exhausted.
+
+        void Fill(void)
+        {
+            uint8_t theBytes[sizeof (mChars) / 4 * 3];
+            size_t  theCount = 0;
+
+            while (theCount < sizeof (theBytes) && mCurrent != mLast)
+            {
+                theBytes[theCount++] = static_cast<uint8_t>(*mCurrent);
+                ++mCurrent;
+            }
+
+            mIndex  = 0;
+            mLength = (theCount > 0) ?
+                static_cast<uint8_t>(nl_base64_encode_flags(theBytes, theCount, mChars, mFlags)) : 0;
+        }
+
+        _Iterator mCurrent;
+        _Iterator mLast;
+        uint8_t   mFlags;
+        uint8_t   mIndex;
+        uint8_t   mLength;
+        char      mChars[64];
+    };
+
+    typedef iterator const_iterator;
+
+    base64_encode_view(_Iterator inFirst, _Iterator inLast, uint8_t inFlags = 0) :
+        mFirst(inFirst),
+        mLast(inLast),
+        mFlags(inFlags)
+    {
+        return;
+    }
+
+    iterator begin(void) const
+    {
+        return iterator(mFirst, mLast, mFlags);
+    }
+
+    iterator end(void) const
+    {
+        return iterator(mLast, mLast, mFlags);
+    }
+
+    /*
+     * The number of characters in the encoding. This is constant time
+     * for random access iterators and linear otherwise.
+     */
+    size_t size(void) const
+    {
+        return nl_base64_encoded_len(static_cast<size_t>(std::distance(mFirst, mLast)),
+                                     (mFlags & NLBASE64_FLAG_NO_PADDING) == 0);
+    }
+
+private:
+    _Iterator mFirst;
+    _Iterator mLast;
+    uint8_t   mFlags;
+};
+
+/*
+ *  class base64_decode_view<>
+ *
+ *  Description:
+ *    This class template presents the characters of the range
+ *    [inFirst, inLast) as the bytes they decode to, accepting the
+ *    URL-safe alphabet as well if NLBASE64_FLAG_URL_SAFE is set. Its
+ *    iterators are input iterators that run the streaming decoder,
+ *    nl_base64_stream_dec_more, over up to 64 characters of the range
+ *    at a time and stop after any '=' padding.
+ *
+ *    If the range is malformed, iteration stops at the error and
+ *    error() becomes true, so the view must outlive its iterators.
+ *
+ *  Parameter(s):
+ *    _Iterator - The type of an input iterator over the characters to
+ *                decode.
+ *
+ */
+template <typename _Iterator>
+class base64_decode_view
+{
+public:
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef uint8_t                 value_type;
+        typedef ptrdiff_t               difference_type;
+        typedef const uint8_t *         pointer;
+        typedef const uint8_t &         reference;
+
+        iterator(void) :
+            mCurrent(),
+            mLast(),
+            mError(NULL),
+            mIndex(0),
+            mLength(0)
+        {
+            nl_base64_stream_dec_start(&mState, NULL, NULL);
+        }
+
+        explicit iterator(_Iterator inLast) :
+            mCurrent(inLast),
+            mLast(inLast),
+            mError(NULL),
+            mIndex(0),
+            mLength(0)
+        {
+            nl_base64_stream_dec_start(&mState, NULL, NULL);
+        }
+
+        iterator(_Iterator inFirst, _Iterator inLast, uint8_t inFlags, bool *inError) :
+            mCurrent(inFirst),
+            mLast(inLast),
+            mError(inError),
+            mIndex(0),
+            mLength(0)
+        {
+            nl_base64_stream_dec_start(&mState, NULL, NULL);
+            nl_base64_stream_dec_set_flags(&mState, inFlags);
+
+            Fill();
+        }
+
+        reference operator *(void) const
+        {
+            return mBytes[mIndex];
+        }
+
+        pointer operator ->(void) const
+        {
+            return &mBytes[mIndex];
+        }
+
+        iterator &operator ++(void)
+        {
+            if (++mIndex == mLength)
+                Fill();
+
+            return *this;
+        }
+
+        iterator operator ++(int)
+        {
+            iterator theResult(*this);
+
+            ++*this;
+
+            return theResult;
+        }
+
+        bool operator ==(const iterator &inOther) const
+        {
+            return (mCurrent == inOther.mCurrent) &&
+                   (mLength - mIndex == inOther.mLength - inOther.mIndex);
+        }
+
+        bool operator !=(const iterator &inOther) const
+        {
+            return !(*this == inOther);
+        }
+
+    private:
+        // Decode up to 64 characters at a time until bytes come out.
+        // Any four consecutive characters complete at most three bytes,
+        // so 64 characters yield at most 48. If the decoder fails part
+        // way, the characters are replayed one at a time from the state
+        // before them, as the decoder writes each byte as soon as its
+        // last character arrives, so that the bytes before the error are
+        // still returned. Once the input is exhausted, the padding is
+        // seen, or an error occurs, the iterator is left equal to the end
+        // iterator.
+
+        void Fill(void)
+        {
+            mIndex  = 0;
+            mLength = 0;
+
+            while (mLength == 0 && mCurrent != mLast && !mState.done && !mState.error)
+            {
+                const nl_base64_stream_dec_state_t theState = mState;
+                char   theChars[sizeof (mBytes) / 3 * 4];
+                size_t theCount = 0;
+                size_t theDecoded;
+                size_t i;
+
+                while (theCount < sizeof (theChars) && mCurrent != mLast)
+                {
+                    theChars[theCount++] = static_cast<char>(*mCurrent);
+                    ++mCurrent;
+                }
+
+                theDecoded = nl_base64_stream_dec_more(theChars, theCount, mBytes, &mState);
+
+                if (theDecoded == SIZE_MAX)
+                {
+                    mState     = theState;
+                    theDecoded = 0;
+
+                    for (i = 0; i < theCount; i++)
+                    {
+                        const size_t theByte = nl_base64_stream_dec_more(&theChars[i], 1, &mBytes[theDecoded], &mState);
+
+                        if (theByte == SIZE_MAX)
+                            break;
+
+                        theDecoded += theByte;
+                    }
+                }
+
+                mLength = static_cast<uint8_t>(theDecoded);
+            }
+
+            if (mLength == 0)
+            {
+                if (nl_base64_stream_dec_finish(&mState) == UINT64_MAX && mError != NULL)
+                    *mError = true;
+
+                mCurrent = mLast;
+            }
+        }
+
+        _Iterator                    mCurrent;
+        _Iterator                    mLast;
+        bool *                       mError;
+        uint8_t                      mIndex;
+        uint8_t                      mLength;
+        uint8_t                      mBytes[48];
+        nl_base64_stream_dec_state_t mState;
+    };
+
+    typedef iterator const_iterator;
+
+    base64_decode_view(_Iterator inFirst, _Iterator inLast, uint8_t inFlags = 0) :
+        mFirst(inFirst),
+        mLast(inLast),
+        mFlags(inFlags),
+        mError(false)
+    {
+        return;
+    }
+
+    iterator begin(void) const
+    {
+        return iterator(mFirst, mLast, mFlags, &mError);
+    }
+
+    iterator end(void) const
+    {
+        return iterator(mLast);
+    }
+
+    /*
+     * Whether iteration has stopped at malformed input.
+     */
+    bool error(void) const
+    {
+        return mError;
+    }
+
+private:
+    _Iterator    mFirst;
+    _Iterator    mLast;
+    uint8_t      mFlags;
+    mutable bool mError;
+};
+
+/*
+ *  base64_encoded<>() / base64_decoded<>()
+ *
+ *  Description:
+ *    These function templates return a view that encodes or decodes
+ *    an iterator range or any range with std::begin and std::end, for
+ *    example:
+ *
+ *      auto theView = nl::base64_decoded(theString);
+ *
+ *      std::copy(theView.begin(), theView.end(), theOutput);
+ *
+ *      if (theView.error())
+ *          ...
+ *
+ *    Note that the range of a string literal includes its null
+ *    terminator.
+ *
+ */
+template <typename _Iterator>
+inline base64_encode_view<_Iterator>
+base64_encoded(_Iterator inFirst, _Iterator inLast, uint8_t inFlags = 0)
+{
+    return base64_encode_view<_Iterator>(inFirst, inLast, inFlags);
+}
+
+template <typename _Range>
+inline auto
+base64_encoded(const _Range &inRange, uint8_t inFlags = 0) -> base64_encode_view<decltype(std::begin(inRange))>
+{
+    return base64_encode_view<decltype(std::begin(inRange))>(std::begin(inRange), std::end(inRange), inFlags);
+}
+
+template <typename _Iterator>
+inline base64_decode_view<_Iterator>
+base64_decoded(_Iterator inFirst, _Iterator inLast, uint8_t inFlags = 0)
+{
+    return base64_decode_view<_Iterator>(inFirst, inLast, inFlags);
+}
+
+template <typename _Range>
+inline auto
+base64_decoded(const _Range &inRange, uint8_t inFlags = 0) -> base64_decode_view<decltype(std::begin(inRange))>
+{
+    return base64_decode_view<decltype(std::begin(inRange))>(std::begin(inRange), std::end(inRange), inFlags);
+}
+
+}; // namespace nl
+
+#endif // __cplusplus >= 201103L
+
+#endif // NLUTILITIES_NLBASE64_HPP
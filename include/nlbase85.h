@@ -0,0 +1,112 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines block- and streaming-based interfaces for
+ *      Ascii85 (base85) encoding and decoding.
+ *
+ */
+
+#ifndef NLUTILITIES_NLBASE85_H
+#define NLUTILITIES_NLBASE85_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Ascii85 encodes each group of 4 bytes as 5 characters from '!' to 'u',
+ * most significant first, and a final group of n < 4 bytes as its first
+ * n + 1 characters, without padding. The "<~" and "~>" delimiters of
+ * the Adobe variant are neither written nor accepted, and whitespace is
+ * not skipped.
+ *
+ * NLBASE85_FLAG_ZERO_GROUPS encodes a whole group of zero bytes as the
+ * single character 'z'. Decoding always accepts 'z' between groups.
+ */
+
+#define NLBASE85_FLAG_ZERO_GROUPS 0x1
+
+/* Block Ascii85 encoder and decoder for inputs of any size. The decoder
+ * returns SIZE_MAX on error.
+ */
+
+extern size_t nl_base85_decode(const char *in, size_t inLen, uint8_t *out);
+extern size_t nl_base85_encode(const uint8_t *in, size_t inLen, char *out, uint8_t flags);
+
+extern size_t nl_base85_decoded_len(const char *in, size_t inLen);
+extern size_t nl_base85_encoded_len(size_t inLen);
+
+/* Streaming Ascii85 encoder for inputs of any size. Output goes a block
+ * at a time to a write function. nl_base85_stream_enc_more returns the
+ * number of characters written by that call and nl_base85_stream_enc_finish
+ * the total.
+ */
+
+typedef void (*nl_base85_stream_enc_write_t)(const char *inChars, size_t inLen, void *inContext);
+
+typedef struct {
+    uint8_t                      encoded[4];
+    uint8_t                      num_encoded;
+    uint8_t                      flags;
+    uint64_t                     num_written;
+    nl_base85_stream_enc_write_t write;
+    void *                       context;
+} nl_base85_stream_enc_state_t;
+
+extern void     nl_base85_stream_enc_start(nl_base85_stream_enc_state_t *state, uint8_t flags,
+                                           nl_base85_stream_enc_write_t out_write,
+                                           void *context);
+extern uint64_t nl_base85_stream_enc_more(const uint8_t *in, size_t inLen,
+                                          nl_base85_stream_enc_state_t *state);
+extern uint64_t nl_base85_stream_enc_finish(nl_base85_stream_enc_state_t *state);
+
+/* Streaming Ascii85 decoder. Requires only O(1) state, accepts fragments
+ * split at any point, and writes decoded bytes either to a caller buffer
+ * or, block by block, to a write function. As the bytes of a final
+ * partial group depend on its last character, they are only written by
+ * nl_base85_stream_dec_finish.
+ */
+
+typedef void (*nl_base85_stream_dec_write_t)(const uint8_t *inBytes, size_t inLen, void *inContext);
+
+typedef struct {
+    uint32_t                     value;
+    uint8_t                      num_decoded;
+    bool                         error;
+    uint64_t                     num_written;
+    nl_base85_stream_dec_write_t write;
+    void *                       context;
+} nl_base85_stream_dec_state_t;
+
+extern void     nl_base85_stream_dec_start(nl_base85_stream_dec_state_t *state,
+                                           nl_base85_stream_dec_write_t out_write,
+                                           void *context);
+extern size_t   nl_base85_stream_dec_more(const char *in, size_t inLen, uint8_t *out,
+                                          nl_base85_stream_dec_state_t *state);
+extern uint64_t nl_base85_stream_dec_finish(uint8_t *out, nl_base85_stream_dec_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NLUTILITIES_NLBASE85_H
@@ -0,0 +1,54 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines interfaces for computing the CRC-32 of
+ *      IEEE 802.3 and the CRC-32C (Castagnoli) of iSCSI and SCTP.
+ *
+ */
+
+#ifndef NLUTILITIES_NLCRC32_H
+#define NLUTILITIES_NLCRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Both functions return the CRC of the inLen bytes at in, continuing
+ * from crc, which is 0 for the first block and the previous result for
+ * each block after it, so that data may be checked in pieces.
+ *
+ * Whether they use the CRC instructions of SSE4.2 or ARMv8 or tables
+ * is chosen when the library is built, from the target the compiler
+ * was given (see NLCRC32_USE_SSE42 and NLCRC32_USE_ARM_CRC32), not by
+ * probing the processor at run time. A library built for such a target
+ * only runs on processors that have the instructions.
+ */
+
+extern uint32_t nl_crc32(uint32_t crc, const void *in, size_t inLen);
+extern uint32_t nl_crc32c(uint32_t crc, const void *in, size_t inLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NLUTILITIES_NLCRC32_H
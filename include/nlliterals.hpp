@@ -0,0 +1,351 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements compile-time base64 and hexadecimal
+ *      encoders and decoders for C++14 and later, so that constant
+ *      blobs written as string literals are decoded by the compiler
+ *      into read-only data rather than at startup.
+ *
+ */
+
+#ifndef NLUTILITIES_NLLITERALS_HPP
+#define NLUTILITIES_NLLITERALS_HPP
+
+#if __cplusplus >= 201402L
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <utility>
+
+namespace nl
+{
+
+namespace _literals
+{
+
+/*
+ * Deliberately not constexpr: reaching it while the compiler evaluates
+ * a literal makes that evaluation fail, so a malformed literal is a
+ * compile-time error.
+ */
+inline uint8_t invalid_literal(void)
+{
+    return 0;
+}
+
+constexpr uint8_t base64_value(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<uint8_t>(c - 'A') :
+           (c >= 'a' && c <= 'z') ? static_cast<uint8_t>(c - 'a' + 26) :
+           (c >= '0' && c <= '9') ? static_cast<uint8_t>(c - '0' + 52) :
+           (c == '+' || c == '-') ? 62 :
+           (c == '/' || c == '_') ? 63 :
+           invalid_literal();
+}
+
+constexpr bool base64_valid(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           c == '+' || c == '-' || c == '/' || c == '_';
+}
+
+constexpr char base64_char(uint8_t v)
+{
+    return (v < 26) ? static_cast<char>('A' + v) :
+           (v < 52) ? static_cast<char>('a' + v - 26) :
+           (v < 62) ? static_cast<char>('0' + v - 52) :
+           (v == 62) ? '+' : '/';
+}
+
+constexpr uint8_t hex_value(char c)
+{
+    return (c >= '0' && c <= '9') ? static_cast<uint8_t>(c - '0') :
+           (c >= 'A' && c <= 'F') ? static_cast<uint8_t>(c - 'A' + 10) :
+           (c >= 'a' && c <= 'f') ? static_cast<uint8_t>(c - 'a' + 10) :
+           invalid_literal();
+}
+
+constexpr bool hex_valid(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+constexpr char hex_char(uint8_t v)
+{
+    return (v > 9) ? static_cast<char>(v - 10 + 'A') : static_cast<char>(v + '0');
+}
+
+/*
+ * Byte i of a decoded base64 string, which takes its bits from two of
+ * the four characters of group i / 3.
+ */
+template <size_t N>
+constexpr uint8_t base64_byte(const char (&in)[N], size_t i)
+{
+    return static_cast<uint8_t>(
+        (i % 3 == 0) ? (base64_value(in[i / 3 * 4 + 0]) << 2) | (base64_value(in[i / 3 * 4 + 1]) >> 4) :
+        (i % 3 == 1) ? (base64_value(in[i / 3 * 4 + 1]) << 4) | (base64_value(in[i / 3 * 4 + 2]) >> 2) :
+                       (base64_value(in[i / 3 * 4 + 2]) << 6) | (base64_value(in[i / 3 * 4 + 3])));
+}
+
+template <size_t N, typename T>
+constexpr uint8_t byte_at(const T &in, size_t i)
+{
+    return (i < N) ? static_cast<uint8_t>(in[i]) : 0;
+}
+
+/*
+ * The 24 bits of group g of N bytes, with zeros past the end.
+ */
+template <size_t N, typename T>
+constexpr uint32_t base64_group(const T &in, size_t g)
+{
+    return (static_cast<uint32_t>(byte_at<N>(in, g * 3)) << 16) |
+           (static_cast<uint32_t>(byte_at<N>(in, g * 3 + 1)) << 8) |
+           byte_at<N>(in, g * 3 + 2);
+}
+
+/*
+ * Character i of the padded base64 encoding of N bytes, or the null
+ * terminator. A group holding r < 3 bytes has r + 1 characters of data.
+ */
+template <size_t N, typename T>
+constexpr char base64_encoded_char(const T &in, size_t i)
+{
+    return (i == (N + 2) / 3 * 4) ? '\0' :
+           (i % 4 > N - i / 4 * 3) ? '=' :
+           base64_char(static_cast<uint8_t>((base64_group<N>(in, i / 4) >> (18 - i % 4 * 6)) & 0x3F));
+}
+
+template <size_t M, size_t N, size_t... I>
+constexpr std::array<uint8_t, M> base64_decode(const char (&in)[N], std::index_sequence<I...>)
+{
+    return std::array<uint8_t, M>{ { base64_byte(in, I)... } };
+}
+
+template <size_t N, typename T, size_t... I>
+constexpr std::array<char, (N + 2) / 3 * 4 + 1> base64_encode(const T &in, std::index_sequence<I...>)
+{
+    return std::array<char, (N + 2) / 3 * 4 + 1>{ { base64_encoded_char<N>(in, I)... } };
+}
+
+template <size_t N, size_t... I>
+constexpr std::array<uint8_t, sizeof... (I)> hex_decode(const char (&in)[N], std::index_sequence<I...>)
+{
+    return std::array<uint8_t, sizeof... (I)>{ { static_cast<uint8_t>((hex_value(in[I * 2]) << 4) |
+                                                                    hex_value(in[I * 2 + 1]))... } };
+}
+
+template <size_t N, typename T, size_t... I>
+constexpr std::array<char, N * 2 + 1> hex_encode(const T &in, std::index_sequence<I...>)
+{
+    return std::array<char, N * 2 + 1>{ { ((I == N * 2) ? '\0' :
+                                          hex_char(static_cast<uint8_t>(
+                                              (static_cast<uint8_t>(in[I / 2]) >> ((I % 2) ? 0 : 4)) & 0xF)))... } };
+}
+
+}; // namespace _literals
+
+/*
+ *  bool base64_literal_valid<>()
+ *
+ *  Description:
+ *    This function template returns whether a string literal is well
+ *    formed base64: characters of the standard or URL-safe alphabet,
+ *    not leaving a single character in the last group, followed by
+ *    either no padding or exactly the padding that completes the last
+ *    group.
+ *
+ */
+template <size_t N>
+constexpr bool base64_literal_valid(const char (&in)[N])
+{
+    size_t length = 0;
+    size_t padding = 0;
+    bool   valid = true;
+
+    while (length < N - 1 && in[length] != '=')
+    {
+        valid = valid && _literals::base64_valid(in[length]);
+        length++;
+    }
+
+    while (length + padding < N - 1 && in[length + padding] == '=')
+        padding++;
+
+    return valid && length % 4 != 1 && length + padding == N - 1 &&
+           padding <= 2 && (padding == 0 || length % 4 + padding == 4);
+}
+
+/*
+ *  size_t base64_decoded_length<>()
+ *
+ *  Description:
+ *    This function template returns the number of bytes a base64
+ *    string literal decodes to, provided that base64_literal_valid()
+ *    holds for it. Otherwise it is not a constant expression, so a
+ *    malformed literal fails to compile wherever the length is needed
+ *    as one, as it is by NL_BASE64_LITERAL.
+ *
+ */
+template <size_t N>
+constexpr size_t base64_decoded_length(const char (&in)[N])
+{
+    size_t length = 0;
+
+    while (length < N - 1 && in[length] != '=')
+        length++;
+
+    return !base64_literal_valid(in) ?
+        _literals::invalid_literal() :
+        length / 4 * 3 + (length % 4) * 3 / 4;
+}
+
+/*
+ *  std::array<uint8_t, M> base64_decode<>()
+ *
+ *  Description:
+ *    This function template decodes a base64 string literal into an
+ *    array of M bytes, where M must be base64_decoded_length() of the
+ *    literal. NL_BASE64_LITERAL supplies M.
+ *
+ */
+template <size_t M, size_t N>
+constexpr std::array<uint8_t, M> base64_decode(const char (&in)[N])
+{
+    return (M != base64_decoded_length(in)) ?
+        (_literals::invalid_literal(), std::array<uint8_t, M>{ }) :
+        _literals::base64_decode<M>(in, std::make_index_sequence<M>());
+}
+
+/*
+ *  std::array<char, L> base64_encode<>()
+ *
+ *  Description:
+ *    These function templates encode an array of bytes, or the
+ *    characters of a string literal without its terminator, into a
+ *    padded, null-terminated base64 string.
+ *
+ */
+template <size_t N>
+constexpr std::array<char, (N + 2) / 3 * 4 + 1> base64_encode(const std::array<uint8_t, N> &in)
+{
+    return _literals::base64_encode<N>(in, std::make_index_sequence<(N + 2) / 3 * 4 + 1>());
+}
+
+template <size_t N>
+constexpr std::array<char, (N + 1) / 3 * 4 + 1> base64_encode(const char (&in)[N])
+{
+    return _literals::base64_encode<N - 1>(in, std::make_index_sequence<(N + 1) / 3 * 4 + 1>());
+}
+
+/*
+ *  bool hex_literal_valid<>()
+ *
+ *  Description:
+ *    This function template returns whether a string literal is an
+ *    even number of hexadecimal digits, in either case.
+ *
+ */
+template <size_t N>
+constexpr bool hex_literal_valid(const char (&in)[N])
+{
+    size_t length = 0;
+
+    while (length < N - 1 && _literals::hex_valid(in[length]))
+        length++;
+
+    return length == N - 1 && length % 2 == 0;
+}
+
+/*
+ *  size_t hex_decoded_length<>()
+ *
+ *  Description:
+ *    This function template returns the number of bytes a hexadecimal
+ *    string literal decodes to, provided that hex_literal_valid()
+ *    holds for it. Otherwise it is not a constant expression, so a
+ *    malformed literal fails to compile wherever the length is needed
+ *    as one, as it is by NL_HEX_LITERAL.
+ *
+ */
+template <size_t N>
+constexpr size_t hex_decoded_length(const char (&in)[N])
+{
+    static_assert((N - 1) % 2 == 0, "hexadecimal literal must have an even number of digits");
+
+    return !hex_literal_valid(in) ? _literals::invalid_literal() : (N - 1) / 2;
+}
+
+/*
+ *  std::array<uint8_t, M> hex_decode<>()
+ *
+ *  Description:
+ *    This function template decodes a hexadecimal string literal,
+ *    without separators, into an array of M bytes, where M must be
+ *    hex_decoded_length() of the literal. NL_HEX_LITERAL supplies M.
+ *
+ */
+template <size_t M, size_t N>
+constexpr std::array<uint8_t, M> hex_decode(const char (&in)[N])
+{
+    return (M != hex_decoded_length(in)) ?
+        (_literals::invalid_literal(), std::array<uint8_t, M>{ }) :
+        _literals::hex_decode(in, std::make_index_sequence<M>());
+}
+
+/*
+ *  std::array<char, N * 2 + 1> hex_encode<>()
+ *
+ *  Description:
+ *    This function template encodes an array of bytes into a
+ *    null-terminated, upper-case hexadecimal string, as
+ *    nl_bintohexstr does without a separator.
+ *
+ */
+template <size_t N>
+constexpr std::array<char, N * 2 + 1> hex_encode(const std::array<uint8_t, N> &in)
+{
+    return _literals::hex_encode<N>(in, std::make_index_sequence<N * 2 + 1>());
+}
+
+}; // namespace nl
+
+/*
+ * Decode a base64 string literal into a std::array of exactly as many
+ * bytes as it holds. Assign the result to a constexpr variable to have
+ * the compiler do the decoding. A malformed literal fails to compile:
+ *
+ *   static constexpr auto kKey = NL_BASE64_LITERAL("q83vEjRWeJA=");
+ */
+#define NL_BASE64_LITERAL(s) (::nl::base64_decode< ::nl::base64_decoded_length(s) >(s))
+
+/*
+ * Decode a hexadecimal string literal into a std::array of half as many
+ * bytes as it has digits, failing to compile unless every character is
+ * a hexadecimal digit.
+ */
+#define NL_HEX_LITERAL(s) (::nl::hex_decode< ::nl::hex_decoded_length(s) >(s))
+
+#endif // __cplusplus >= 201402L
+
+#endif // NLUTILITIES_NLLITERALS_HPP
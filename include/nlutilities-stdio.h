@@ -0,0 +1,54 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines the Nest Labs Utilities C interfaces that
+ *      take a stdio stream, kept out of nlutilities.h so that it may be
+ *      used on targets without stdio.
+ *
+ */
+
+#ifndef NLUTILITIES_NLUTILITIES_STDIO_H
+#define NLUTILITIES_NLUTILITIES_STDIO_H
+
+#include <stdio.h>
+
+#include <nlutilities.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+    A write function that passes the output of nl_dump_bytes_write,
+    nl_dump_bytes_flags or nl_dump_bytes_diff to a stdio stream, given a
+    FILE * as context.
+*/
+extern void nl_dump_bytes_file_write(const char *inChars, size_t inLen, void *inContext);
+
+/*!
+    Format a block of memory as nl_dump_bytes does to a stdio stream.
+*/
+extern void nl_dump_bytes_file(FILE *file, uintptr_t offs, const uint8_t *bytes, size_t num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NLUTILITIES_NLUTILITIES_STDIO_H
@@ -30,8 +30,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <nlbase32.h>
 #include <nlbase64.h>
+#include <nlbase85.h>
 #include <nlcore.h>
+#include <nlcrc32.h>
 #include <nlfixedpoint.h>
 #include <nlmacros.h>
 #include <nlmemset16.h>
@@ -43,6 +46,19 @@ extern "C" {
 extern int nl_hextobin(char c);
 extern void nl_strhextobin(uint8_t *bin, const char *hex, size_t len);
 
+/*!
+    Decode len bytes from the 2 * len hexadecimal digits, of either case,
+    at hex, validating every digit, unlike nl_strhextobin. The destination
+    may be the same buffer as the source to decode in place.
+    @arg bin The destination buffer for the decoded bytes
+    @arg hex The source buffer containing the hexadecimal digits
+    @arg len The number of bytes to decode
+    @return 2 * len on success; otherwise, the offset in hex of the first
+            character that is not a hexadecimal digit, all bytes before
+            which have been decoded.
+*/
+extern size_t nl_strhextobin_checked(uint8_t *bin, const char *hex, size_t len);
+
 /*!
     Write an array of bytes out as a hex string. Caller should ensure that
     the size of dest is large enough to hold the hex string, plus separators,
@@ -55,9 +71,147 @@ extern void nl_strhextobin(uint8_t *bin, const char *hex, size_t len);
     @arg sep The separator character to use between chunks
 */
 extern char *nl_bintohexstr(char *dest, const uint8_t *src, size_t len, char sep);
+
+/* Write hexadecimal digits in lower case rather than upper case. */
+
+#define NLBINTOHEX_FLAG_LOWER_CASE 0x1
+
+/*!
+    Write an array of bytes out as a hex string, in the case selected by
+    flags, with the separator string sep between each group of group
+    bytes; for example, group 1 and ":" gives "aa:bb:cc". A group of 0,
+    or a NULL or empty sep, writes no separators. Caller should ensure
+    that the size of dest is at least the length from
+    nl_bintohexstr_grouped_len plus 1 byte for the null terminator.
+    @arg dest The destination buffer to put the hex string
+    @arg src The source buffer containing the binary data
+    @arg srclen The length of the source buffer
+    @arg group The number of bytes between separators
+    @arg sep The separator string
+    @arg flags Zero or more NLBINTOHEX_FLAG_* flags
+    @return dest
+*/
+extern char *nl_bintohexstr_grouped(char *dest, const uint8_t *src, size_t srclen, size_t group, const char *sep, uint8_t flags);
+
+/*!
+    Return the length, excluding the null terminator, of the hex string
+    that nl_bintohexstr_grouped writes for srclen bytes with the given
+    group size and separator length.
+*/
+extern size_t nl_bintohexstr_grouped_len(size_t srclen, size_t group, size_t seplen);
+
 extern bool nl_isxdigitstr(const char *s);
+
+/*!
+    Return the index of the first character among the first len of s
+    that is not a hexadecimal digit, or len if all of them are. Unlike
+    nl_isxdigitstr, s need not be null-terminated and the classification
+    does not depend on the current locale.
+    @arg s The characters to classify
+    @arg len The number of characters to classify
+*/
+extern size_t nl_isxdigitstrn(const char *s, size_t len);
 extern int nl_getCharSeparatedBytes(const char* inBuffer, uint8_t* outBytes, size_t inNumValues, char inSeparator, int inBase);
+
+/*!
+    Parse each of an array of character-separated byte strings, such as
+    MAC addresses, as nl_getCharSeparatedBytes does.
+    @arg inBuffers The null-terminated strings to parse
+    @arg inNumBuffers The number of strings to parse
+    @arg outBytes The destination for inNumValues bytes per string, those
+         of string i starting at outBytes[i * inNumValues]
+    @arg inNumValues The number of bytes in each string
+    @arg inSeparator The character separating the bytes
+    @arg inBase The base of the bytes, as for strtoul
+    @arg outNumParsed Optionally, NULL or the destination for the number
+         of bytes parsed from each string before any error
+    @return The number of strings from which all inNumValues bytes were
+            parsed
+*/
+extern size_t nl_getCharSeparatedBytesBatch(const char* const* inBuffers, size_t inNumBuffers, uint8_t* outBytes, size_t inNumValues, char inSeparator, int inBase, int* outNumParsed);
+
+/*!
+    Pretty-print a block of memory to standard output, 16 bytes per line
+    as the offset, the bytes in hexadecimal and the bytes as characters,
+    with '.' for those that are not printable.
+    @arg offs The offset, or address, to label the first byte with
+    @arg bytes The bytes to print
+    @arg num The number of bytes to print
+*/
 extern void nl_dump_bytes(uintptr_t offs, const uint8_t *bytes, size_t num);
+
+/*!
+    The function to which nl_dump_bytes_write passes its output, several
+    whole lines at a time.
+*/
+typedef void (*nl_dump_bytes_write_t)(const char *inChars, size_t inLen, void *inContext);
+
+/*!
+    Format a block of memory as nl_dump_bytes does, passing the output to
+    out_write a batch of NLDUMPBYTES_LINES_PER_WRITE lines at a time.
+*/
+extern void nl_dump_bytes_write(uintptr_t offs, const uint8_t *bytes, size_t num, nl_dump_bytes_write_t out_write, void *context);
+
+/* Collapse each run of whole lines that are the same as the line before
+ * them into a single "*" line, as hexdump -C does. A dump that ends in
+ * such a run ends with a line holding just the offset past its end.
+ */
+
+#define NLDUMPBYTES_FLAG_SQUEEZE 0x1
+
+/*!
+    Format a block of memory as nl_dump_bytes_write does, in the mode
+    selected by zero or more NLDUMPBYTES_FLAG_* flags.
+*/
+extern void nl_dump_bytes_flags(uintptr_t offs, const uint8_t *bytes, size_t num, uint8_t flags, nl_dump_bytes_write_t out_write, void *context);
+
+/*!
+    Format only the lines that differ between two snapshots of a block of
+    memory, each as a pair of lines formatted as nl_dump_bytes does: that
+    of before prefixed with '-' and that of after prefixed with '+'.
+    @arg offs The offset, or address, to label the first byte with
+    @arg before The earlier snapshot
+    @arg after The later snapshot
+    @arg num The number of bytes in each snapshot
+*/
+extern void nl_dump_bytes_diff(uintptr_t offs, const uint8_t *before, const uint8_t *after, size_t num, nl_dump_bytes_write_t out_write, void *context);
+
+#if defined(__unix__) || defined(__APPLE__)
+/*!
+    A write function that passes the output of nl_dump_bytes_write,
+    nl_dump_bytes_flags or nl_dump_bytes_diff to a file descriptor, given
+    a pointer to an int as context. The equivalent for a stdio stream is
+    declared in nlutilities-stdio.h. Available on POSIX targets only.
+*/
+extern void nl_dump_bytes_fd_write(const char *inChars, size_t inLen, void *inContext);
+
+/*!
+    Format a block of memory as nl_dump_bytes does to a file descriptor.
+    Available on POSIX targets only.
+*/
+extern void nl_dump_bytes_fd(int fd, uintptr_t offs, const uint8_t *bytes, size_t num);
+#endif /* defined(__unix__) || defined(__APPLE__) */
+
+/*!
+    Dump a regular file, as nl_dump_bytes_flags would dump its contents
+    with the first byte labeled offs, by memory mapping it and
+    formatting successive slices of it on num_tasks threads, or one per
+    online CPU if num_tasks is 0. The output is passed to out_write in
+    order, one slice at a time, from the calling thread.
+    @return 0 on success, or -1 with errno set if the file could not be
+            mapped or the buffers allocated, in which case nothing has
+            been written
+*/
+extern int nl_dump_file_parallel(int fd, uintptr_t offs, uint8_t flags, size_t num_tasks, nl_dump_bytes_write_t out_write, void *context);
+
+/*!
+    Format a block of memory as nl_dump_bytes does into a buffer of size
+    characters, which is always null-terminated if size is not zero.
+    @return The length of the full output, excluding the null
+            terminator, which was truncated if this is not less than size.
+*/
+extern size_t nl_dump_bytes_buffer(char *buffer, size_t size, uintptr_t offs, const uint8_t *bytes, size_t num);
+
 extern void nl_printBytesWithSeparator( const uint8_t* inBytes, size_t inNumValues, char inSeparator);
 extern size_t nl_strncpyprettyprint(char *inOutDest, const char *inSource, size_t inBufferCapacity);
 
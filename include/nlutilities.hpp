@@ -28,6 +28,8 @@
 
 #include <nlalgorithm.hpp>
 #include <nlalignedvarpool.hpp>
+#include <nlbase64.hpp>
+#include <nlliterals.hpp>
 #include <nlnew.hpp>
 #include <nlnoncopyable.hpp>
 
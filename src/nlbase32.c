@@ -0,0 +1,539 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements block- and streaming-based interfaces for
+ *      base32 encoding and decoding.
+ *
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <nlbase32.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nlutilities-internal.h"
+
+/*
+ * The number of characters or bytes the streaming encoder and decoder
+ * stage on the stack when they run whole groups through the block
+ * encoder or pass decoded blocks to a write function. Must be a
+ * multiple of 8.
+ */
+#define NLBASE32_STREAM_CHUNK_SIZE 256
+
+// Set in a decode table entry for any character outside the alphabet.
+// It lies above the 5 bits of a decoded character, so OR-ing the
+// entries for all eight characters of a group preserves it.
+
+#define NLBASE32_INVALID 0x80
+
+// Both cases of each letter decode alike.
+
+#define NLBASE32_VAL(c)                                         \
+    ((c) >= 'A' && (c) <= 'Z' ? (c) - 'A' :                     \
+     (c) >= 'a' && (c) <= 'z' ? (c) - 'a' :                     \
+     (c) >= '2' && (c) <= '7' ? (c) - '2' + 26 : NLBASE32_INVALID)
+
+#define NLBASE32_HEX_VAL(c)                                     \
+    ((c) >= '0' && (c) <= '9' ? (c) - '0' :                     \
+     (c) >= 'A' && (c) <= 'V' ? (c) - 'A' + 10 :                \
+     (c) >= 'a' && (c) <= 'v' ? (c) - 'a' + 10 : NLBASE32_INVALID)
+
+// Indexed by whether NLBASE32_FLAG_HEX is set.
+
+static const uint8_t nl_base32_dec_tables[2][256] = {
+    { NL_TABLE256(NLBASE32_VAL)     },
+    { NL_TABLE256(NLBASE32_HEX_VAL) }
+};
+
+// Indexed by nl_base32_alphabet_index().
+
+static const char nl_base32_alphabets[4][32] = {
+    { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+      'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '2', '3', '4', '5', '6', '7' },
+    { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
+      'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '2', '3', '4', '5', '6', '7' },
+    { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+      'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V' },
+    { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+      'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v' }
+};
+
+static inline const char *nl_base32_alphabet(uint8_t flags)
+{
+    return nl_base32_alphabets[((flags & NLBASE32_FLAG_HEX) ? 2 : 0) |
+                               ((flags & NLBASE32_FLAG_LOWER_CASE) ? 1 : 0)];
+}
+
+static inline const uint8_t *nl_base32_dec_table(uint8_t flags)
+{
+    return nl_base32_dec_tables[(flags & NLBASE32_FLAG_HEX) ? 1 : 0];
+}
+
+// A final group of n characters carries n * 5 bits, of which whole
+// bytes are decoded and the rest, which must be fewer than the 5 bits of
+// a character, are discarded. This leaves 2, 4, 5 and 7 as the only
+// valid lengths of a partial group.
+
+static inline bool nl_base32_is_partial_len(size_t n)
+{
+    return (n * 5) % 8 < 5;
+}
+
+// Return the exact length of the string that encoding inLen bytes
+// produces, with or without padding, not including any null terminator.
+//
+size_t nl_base32_encoded_len(size_t inLen, bool pad)
+{
+    const size_t remainder = inLen % 5;
+    size_t len = (inLen / 5) * 8;
+
+    if (remainder != 0)
+        len += pad ? 8 : (remainder * 8 + 4) / 5;
+
+    return len;
+}
+
+// Return the exact number of bytes that decoding a well-formed, padded or
+// unpadded, base32 string of inLen characters produces. For malformed
+// input, the result is an upper bound on the number of bytes that
+// nl_base32_decode writes before it reports an error.
+//
+size_t nl_base32_decoded_len(const char *in, size_t inLen)
+{
+    while (inLen > 0 && in[inLen - 1] == '=')
+        inLen--;
+
+    return (inLen / 8) * 5 + ((inLen % 8) * 5) / 8;
+}
+
+// Encode as many whole 5-byte groups as are available in the input, one
+// table lookup per character.
+//
+// Returns the number of input bytes consumed; the number of characters
+// written is 8/5 of that.
+//
+static size_t nl_base32_encode_groups(const uint8_t *in, size_t inLen, char *out, const char *alphabet)
+{
+    const uint8_t *inStart = in;
+
+    while (inLen >= 5)
+    {
+        const uint64_t val = ((uint64_t)in[0] << 32) | ((uint32_t)in[1] << 24) |
+                             ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 8) | in[4];
+
+        out[0] = alphabet[(val >> 35) & 0x1F];
+        out[1] = alphabet[(val >> 30) & 0x1F];
+        out[2] = alphabet[(val >> 25) & 0x1F];
+        out[3] = alphabet[(val >> 20) & 0x1F];
+        out[4] = alphabet[(val >> 15) & 0x1F];
+        out[5] = alphabet[(val >> 10) & 0x1F];
+        out[6] = alphabet[(val >>  5) & 0x1F];
+        out[7] = alphabet[(val >>  0) & 0x1F];
+
+        in += 5;
+        inLen -= 5;
+        out += 8;
+    }
+
+    return in - inStart;
+}
+
+// Encode a final group of fewer than 5 bytes, with or without padding.
+//
+// Returns the number of characters written.
+//
+static size_t nl_base32_encode_partial(const uint8_t *in, size_t inLen, char *out,
+                                       const char *alphabet, bool pad)
+{
+    const size_t len = (inLen * 8 + 4) / 5;
+    uint64_t val = 0;
+    size_t i;
+
+    for (i = 0; i < 5; i++)
+        val = (val << 8) | ((i < inLen) ? in[i] : 0);
+
+    for (i = 0; i < len; i++)
+        out[i] = alphabet[(val >> (35 - i * 5)) & 0x1F];
+
+    if (!pad || inLen == 0)
+        return len;
+
+    for (; i < 8; i++)
+        out[i] = '=';
+
+    return 8;
+}
+
+// Encode in the standard or extended hex alphabet, in either case, with
+// or without padding.
+//
+// Returns the number of characters written, which is not null-terminated.
+//
+size_t nl_base32_encode(const uint8_t *in, size_t inLen, char *out, uint8_t flags)
+{
+    const char *alphabet = nl_base32_alphabet(flags);
+    const size_t consumed = nl_base32_encode_groups(in, inLen, out, alphabet);
+    const size_t written = consumed / 5 * 8;
+
+    return written + nl_base32_encode_partial(in + consumed, inLen - consumed, out + written,
+                                              alphabet, (flags & NLBASE32_FLAG_NO_PADDING) == 0);
+}
+
+// Decode as many whole 8-character groups as are available in the input,
+// stopping at the first group that holds padding or any character
+// outside the alphabet.
+//
+// Returns the number of characters consumed; the number of bytes written
+// is 5/8 of that.
+//
+static size_t nl_base32_decode_groups(const char *in, size_t inLen, uint8_t *out, const uint8_t *table)
+{
+    const char *inStart = in;
+
+    while (inLen >= 8)
+    {
+        const uint8_t a = table[(uint8_t)in[0]];
+        const uint8_t b = table[(uint8_t)in[1]];
+        const uint8_t c = table[(uint8_t)in[2]];
+        const uint8_t d = table[(uint8_t)in[3]];
+        const uint8_t e = table[(uint8_t)in[4]];
+        const uint8_t f = table[(uint8_t)in[5]];
+        const uint8_t g = table[(uint8_t)in[6]];
+        const uint8_t h = table[(uint8_t)in[7]];
+
+        if ((a | b | c | d | e | f | g | h) & NLBASE32_INVALID)
+            break;
+
+        const uint64_t val = ((uint64_t)a << 35) | ((uint64_t)b << 30) | ((uint64_t)c << 25) |
+                             ((uint32_t)d << 20) | ((uint32_t)e << 15) | ((uint32_t)f << 10) |
+                             ((uint32_t)g << 5) | h;
+
+        out[0] = (uint8_t)(val >> 32);
+        out[1] = (uint8_t)(val >> 24);
+        out[2] = (uint8_t)(val >> 16);
+        out[3] = (uint8_t)(val >> 8);
+        out[4] = (uint8_t)(val >> 0);
+
+        in += 8;
+        inLen -= 8;
+        out += 5;
+    }
+
+    return in - inStart;
+}
+
+// Decode in the standard or extended hex alphabet, in either case. Any
+// input after '=' padding is ignored.
+//
+// Returns the number of bytes decoded, or SIZE_MAX on error.
+//
+size_t nl_base32_decode(const char *in, size_t inLen, uint8_t *out, uint8_t flags)
+{
+    const uint8_t *table = nl_base32_dec_table(flags);
+    const size_t consumed = nl_base32_decode_groups(in, inLen, out, table);
+    uint8_t *outStart = out;
+    uint64_t val = 0;
+    size_t n = 0;
+    size_t i;
+
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 8 * 5;
+
+    // The whole groups have been decoded, so what is left is at most one
+    // group, which must either end the input or be followed by padding.
+
+    while (n < inLen && n < 8 && in[n] != '=')
+    {
+        const uint8_t v = table[(uint8_t)in[n]];
+
+        if (v & NLBASE32_INVALID)
+            return SIZE_MAX;
+
+        val = (val << 5) | v;
+        n++;
+    }
+
+    if (n == 8 || (n < inLen && n == 0) || !nl_base32_is_partial_len(n))
+        return SIZE_MAX;
+
+    val <<= 40 - n * 5;
+
+    for (i = 0; i < n * 5 / 8; i++)
+        out[i] = (uint8_t)(val >> (32 - i * 8));
+
+    return (out - outStart) + i;
+}
+
+//
+// Encode Base32 in O(1) space
+//
+void nl_base32_stream_enc_start(nl_base32_stream_enc_state_t *state, uint8_t flags,
+                                nl_base32_stream_enc_write_t out_write, void *context)
+{
+    state->num_encoded = 0;
+    state->flags       = flags;
+    state->num_written = 0;
+    state->write       = out_write;
+    state->context     = context;
+}
+
+// Returns the number of characters written by this call.
+//
+uint64_t nl_base32_stream_enc_more(const uint8_t *in, size_t inLen,
+                                   nl_base32_stream_enc_state_t *state)
+{
+    const uint64_t was_written = state->num_written;
+    const char *alphabet = nl_base32_alphabet(state->flags);
+    char chunk[NLBASE32_STREAM_CHUNK_SIZE];
+    size_t len = 0;
+
+    // Complete any group left over from the previous fragment.
+
+    if (state->num_encoded > 0)
+    {
+        while (state->num_encoded < 5 && inLen > 0)
+        {
+            state->encoded[state->num_encoded++] = *in++;
+            inLen--;
+        }
+
+        if (state->num_encoded < 5)
+            return (state->num_written - was_written);
+
+        len = nl_base32_encode_groups(state->encoded, 5, chunk, alphabet) / 5 * 8;
+        state->num_encoded = 0;
+    }
+
+    // Then run whole groups through the block encoder a chunk at a time.
+
+    while (inLen >= 5)
+    {
+        size_t avail = (sizeof (chunk) - len) / 8 * 5;
+        size_t consumed;
+
+        if (avail > inLen)
+            avail = inLen;
+
+        consumed = nl_base32_encode_groups(in, avail, chunk + len, alphabet);
+        len += consumed / 5 * 8;
+        in += consumed;
+        inLen -= consumed;
+
+        if (len + 8 > sizeof (chunk))
+        {
+            state->write(chunk, len, state->context);
+            state->num_written += len;
+            len = 0;
+        }
+    }
+
+    if (len > 0)
+    {
+        state->write(chunk, len, state->context);
+        state->num_written += len;
+    }
+
+    memcpy(state->encoded, in, inLen);
+    state->num_encoded = (uint8_t)inLen;
+
+    return (state->num_written - was_written);
+}
+
+// Complete encoding, padding the final group unless the encoder was
+// started with NLBASE32_FLAG_NO_PADDING.
+//
+// Returns the total number of characters written.
+//
+uint64_t nl_base32_stream_enc_finish(nl_base32_stream_enc_state_t *state)
+{
+    char group[8];
+    size_t len;
+
+    len = nl_base32_encode_partial(state->encoded, state->num_encoded, group,
+                                   nl_base32_alphabet(state->flags),
+                                   (state->flags & NLBASE32_FLAG_NO_PADDING) == 0);
+
+    if (len > 0)
+    {
+        state->write(group, len, state->context);
+        state->num_written += len;
+    }
+
+    state->num_encoded = 0;
+
+    return state->num_written;
+}
+
+//
+// Decode Base32 in O(1) space
+//
+void nl_base32_stream_dec_start(nl_base32_stream_dec_state_t *state, uint8_t flags,
+                                nl_base32_stream_dec_write_t out_write, void *context)
+{
+    state->bits        = 0;
+    state->num_bits    = 0;
+    state->num_decoded = 0;
+    state->flags       = flags;
+    state->done        = false;
+    state->error       = false;
+    state->num_written = 0;
+    state->write       = out_write;
+    state->context     = context;
+}
+
+// Decode one fragment into out, carrying the bits of a group split
+// across fragments in state. Whole groups at a group boundary go through
+// the block decoder; the rest are decoded a character at a time, each
+// byte being written as soon as its last bit arrives.
+//
+// Returns the number of bytes written to out, or SIZE_MAX on error.
+//
+static size_t nl_base32_stream_dec_fragment(const char *in, size_t inLen, uint8_t *out,
+                                            nl_base32_stream_dec_state_t *state)
+{
+    const uint8_t *table = nl_base32_dec_table(state->flags);
+    uint8_t *outStart = out;
+
+    while (inLen > 0)
+    {
+        uint8_t val;
+        char ch;
+
+        if (state->num_decoded == 0)
+        {
+            const size_t consumed = nl_base32_decode_groups(in, inLen, out, table);
+
+            in += consumed;
+            inLen -= consumed;
+            out += consumed / 8 * 5;
+
+            if (inLen == 0)
+                break;
+        }
+
+        ch = *in++;
+        inLen--;
+
+        if (ch == '=')
+        {
+            state->done = true;
+
+            if (state->num_decoded == 0 || !nl_base32_is_partial_len(state->num_decoded))
+                state->error = true;
+
+            break;
+        }
+
+        val = table[(uint8_t)ch];
+
+        if (val & NLBASE32_INVALID)
+        {
+            state->error = true;
+            break;
+        }
+
+        state->bits = (state->bits << 5) | val;
+        state->num_bits += 5;
+
+        if (state->num_bits >= 8)
+        {
+            state->num_bits -= 8;
+            *out++ = (uint8_t)(state->bits >> state->num_bits);
+            state->bits &= (1U << state->num_bits) - 1;
+        }
+
+        state->num_decoded = (state->num_decoded + 1) % 8;
+    }
+
+    return state->error ? SIZE_MAX : (size_t)(out - outStart);
+}
+
+// Decode a fragment of a base32 string. If out is not NULL, the decoded
+// bytes are written there, and it must have room for
+// nl_base32_decoded_len(in, inLen) + 1 bytes; otherwise they are passed
+// to the write function a block at a time.
+//
+// Returns the number of bytes decoded from this fragment, or SIZE_MAX on
+// error. Any input after '=' padding is ignored.
+//
+size_t nl_base32_stream_dec_more(const char *in, size_t inLen, uint8_t *out,
+                                 nl_base32_stream_dec_state_t *state)
+{
+    size_t produced = 0;
+
+    if (state->error)
+        return SIZE_MAX;
+
+    if (out != NULL)
+    {
+        if (!state->done)
+            produced = nl_base32_stream_dec_fragment(in, inLen, out, state);
+    }
+    else
+    {
+        while (inLen > 0 && !state->done)
+        {
+            // A chunk of N characters decodes to at most N bytes.
+
+            uint8_t chunk[NLBASE32_STREAM_CHUNK_SIZE];
+            const size_t consumed = (inLen < sizeof (chunk)) ? inLen : sizeof (chunk);
+            const size_t decoded = nl_base32_stream_dec_fragment(in, consumed, chunk, state);
+
+            if (decoded == SIZE_MAX)
+            {
+                produced = SIZE_MAX;
+                break;
+            }
+
+            if (decoded > 0)
+                state->write(chunk, decoded, state->context);
+
+            produced += decoded;
+            in += consumed;
+            inLen -= consumed;
+        }
+    }
+
+    if (produced != SIZE_MAX)
+        state->num_written += produced;
+
+    return produced;
+}
+
+// Complete decoding.
+//
+// Returns the total number of bytes decoded, or UINT64_MAX if the string
+// was malformed, including if it ended with a partial group of a length
+// that no byte count encodes to.
+//
+uint64_t nl_base32_stream_dec_finish(nl_base32_stream_dec_state_t *state)
+{
+    if (!state->done && !nl_base32_is_partial_len(state->num_decoded))
+        state->error = true;
+
+    return state->error ? UINT64_MAX : state->num_written;
+}
@@ -0,0 +1,262 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements parallel interfaces for base64 encoding and
+ *      decoding of very large buffers.
+ *
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <nlbase64.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+/**
+ *  @def NLBASE64_USE_PTHREADS
+ *
+ *  @brief
+ *    The POSIX threads build feature lets the parallel encoder and
+ *    decoder create their own threads when the caller does not supply
+ *    a run function. Without it, such calls run every chunk on the
+ *    calling thread. It is enabled by default whenever the target
+ *    advertises POSIX threads.
+ */
+#ifndef NLBASE64_USE_PTHREADS
+#if defined(_POSIX_THREADS) && (_POSIX_THREADS > 0)
+#define NLBASE64_USE_PTHREADS 1
+#else
+#define NLBASE64_USE_PTHREADS 0
+#endif
+#endif /* NLBASE64_USE_PTHREADS */
+
+/*
+ * The largest number of chunks a buffer is split into. Bounds the
+ * per-call bookkeeping, which lives on the stack.
+ */
+#define NLBASE64_PARALLEL_MAX_TASKS 64
+
+/*
+ * The smallest chunk, in groups, worth handing to another thread. Below
+ * this, thread startup costs more than the coding it saves.
+ */
+#define NLBASE64_PARALLEL_MIN_GROUPS 16384
+
+#if NLBASE64_USE_PTHREADS
+#include <pthread.h>
+#endif
+
+typedef struct {
+    const void *in;
+    size_t      inLen;
+    void *      out;
+    size_t      chunk_groups;
+    size_t      results[NLBASE64_PARALLEL_MAX_TASKS];
+} nl_base64_parallel_job_t;
+
+#if NLBASE64_USE_PTHREADS
+typedef struct {
+    nl_base64_parallel_task_t task;
+    void *                    context;
+    size_t                    index;
+} nl_base64_parallel_thread_t;
+
+static void *nl_base64_parallel_thread(void *inArgument)
+{
+    nl_base64_parallel_thread_t *thread = (nl_base64_parallel_thread_t *)inArgument;
+
+    thread->task(thread->index, thread->context);
+
+    return NULL;
+}
+#endif /* NLBASE64_USE_PTHREADS */
+
+// Runs each task on its own thread, with the first on the calling thread.
+// Any task whose thread cannot be created also runs on the calling thread.
+
+static void nl_base64_parallel_run(nl_base64_parallel_task_t task, void *task_context,
+                                   size_t num_tasks)
+{
+    size_t i;
+#if NLBASE64_USE_PTHREADS
+    nl_base64_parallel_thread_t threads[NLBASE64_PARALLEL_MAX_TASKS];
+    pthread_t                   ids[NLBASE64_PARALLEL_MAX_TASKS];
+    bool                        started[NLBASE64_PARALLEL_MAX_TASKS];
+
+    for (i = 1; i < num_tasks; i++)
+    {
+        threads[i].task    = task;
+        threads[i].context = task_context;
+        threads[i].index   = i;
+        started[i] = (pthread_create(&ids[i], NULL, nl_base64_parallel_thread, &threads[i]) == 0);
+    }
+
+    task(0, task_context);
+
+    for (i = 1; i < num_tasks; i++)
+    {
+        if (started[i])
+            pthread_join(ids[i], NULL);
+        else
+            task(i, task_context);
+    }
+#else
+    for (i = 0; i < num_tasks; i++)
+        task(i, task_context);
+#endif /* NLBASE64_USE_PTHREADS */
+}
+
+// Splits num_groups groups into at most num_tasks chunks of at least
+// NLBASE64_PARALLEL_MIN_GROUPS groups each and returns the number of
+// chunks, storing the size of all but the last in chunk_groups.
+
+static size_t nl_base64_parallel_split(size_t num_groups, size_t num_tasks, size_t *chunk_groups)
+{
+    size_t groups;
+
+    if (num_tasks == 0)
+    {
+#if NLBASE64_USE_PTHREADS && defined(_SC_NPROCESSORS_ONLN)
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        num_tasks = (cpus > 0) ? (size_t)cpus : 1;
+#else
+        num_tasks = 1;
+#endif
+    }
+
+    if (num_tasks > NLBASE64_PARALLEL_MAX_TASKS)
+        num_tasks = NLBASE64_PARALLEL_MAX_TASKS;
+
+    groups = num_groups / num_tasks + (num_groups % num_tasks != 0);
+
+    if (groups < NLBASE64_PARALLEL_MIN_GROUPS)
+        groups = NLBASE64_PARALLEL_MIN_GROUPS;
+
+    *chunk_groups = groups;
+
+    return num_groups / groups + (num_groups % groups != 0);
+}
+
+static void nl_base64_parallel_dispatch(nl_base64_parallel_task_t task,
+                                        nl_base64_parallel_job_t *job, size_t num_tasks,
+                                        nl_base64_parallel_run_t run, void *context)
+{
+    if (num_tasks == 1)
+        task(0, job);
+    else if (run != NULL)
+        run(task, job, num_tasks, context);
+    else
+        nl_base64_parallel_run(task, job, num_tasks);
+}
+
+static void nl_base64_parallel_encode_task(size_t inIndex, void *inContext)
+{
+    nl_base64_parallel_job_t *job   = (nl_base64_parallel_job_t *)inContext;
+    size_t                    start = inIndex * job->chunk_groups * 3;
+    size_t                    len   = job->inLen - start;
+
+    if (len > job->chunk_groups * 3)
+        len = job->chunk_groups * 3;
+
+    nl_base64_encode_ex((const uint8_t *)job->in + start, len,
+                        (char *)job->out + inIndex * job->chunk_groups * 4);
+}
+
+size_t nl_base64_encode_parallel(const uint8_t *in, size_t inLen, char *out,
+                                 size_t num_tasks,
+                                 nl_base64_parallel_run_t run, void *context)
+{
+    nl_base64_parallel_job_t job;
+
+    job.in    = in;
+    job.inLen = inLen;
+    job.out   = out;
+
+    // Every chunk but the last is a whole number of groups, so only the
+    // last can be padded.
+
+    num_tasks = nl_base64_parallel_split(inLen / 3 + (inLen % 3 != 0), num_tasks, &job.chunk_groups);
+
+    if (num_tasks <= 1)
+        return nl_base64_encode_ex(in, inLen, out);
+
+    nl_base64_parallel_dispatch(nl_base64_parallel_encode_task, &job, num_tasks, run, context);
+
+    return nl_base64_encoded_len(inLen, true);
+}
+
+static void nl_base64_parallel_decode_task(size_t inIndex, void *inContext)
+{
+    nl_base64_parallel_job_t *job   = (nl_base64_parallel_job_t *)inContext;
+    size_t                    start = inIndex * job->chunk_groups * 4;
+    size_t                    len   = job->inLen - start;
+
+    if (len > job->chunk_groups * 4)
+        len = job->chunk_groups * 4;
+
+    job->results[inIndex] = nl_base64_decode_ex((const char *)job->in + start, len,
+                                                (uint8_t *)job->out + inIndex * job->chunk_groups * 3);
+}
+
+size_t nl_base64_decode_parallel(const char *in, size_t inLen, uint8_t *out,
+                                 size_t num_tasks,
+                                 nl_base64_parallel_run_t run, void *context)
+{
+    nl_base64_parallel_job_t job;
+    size_t                   outLen = 0;
+    size_t                   i;
+
+    job.in    = in;
+    job.inLen = inLen;
+    job.out   = out;
+
+    num_tasks = nl_base64_parallel_split(inLen / 4 + (inLen % 4 != 0), num_tasks, &job.chunk_groups);
+
+    if (num_tasks <= 1)
+        return nl_base64_decode_ex(in, inLen, out);
+
+    nl_base64_parallel_dispatch(nl_base64_parallel_decode_task, &job, num_tasks, run, context);
+
+    // Each chunk starts on a group boundary, where the sequential decoder
+    // carries no state, so the chunk results combine exactly as it would
+    // have seen them: the first error or padding ends the output, and
+    // anything decoded past padding is ignored.
+
+    for (i = 0; i < num_tasks; i++)
+    {
+        if (job.results[i] == SIZE_MAX)
+            return SIZE_MAX;
+
+        outLen += job.results[i];
+
+        if (job.results[i] < job.chunk_groups * 3)
+            break;
+    }
+
+    return outLen;
+}
@@ -28,10 +28,247 @@
 #endif
 
 #include <nlbase64.h>
+#include <nlmacros.h>
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
+#include "nlutilities-internal.h"
+
+/**
+ *  @def NLBASE64_USE_SSE2
+ *
+ *  @brief
+ *    The SSE2 build feature enables vectorized block encoders and
+ *    decoders that convert between 12 bytes and 16 characters per
+ *    iteration. It is enabled by default whenever the compiler
+ *    targets SSE2.
+ */
+#ifndef NLBASE64_USE_SSE2
+#if defined(__SSE2__)
+#define NLBASE64_USE_SSE2 1
+#else
+#define NLBASE64_USE_SSE2 0
+#endif
+#endif /* NLBASE64_USE_SSE2 */
+
+/**
+ *  @def NLBASE64_USE_AVX2
+ *
+ *  @brief
+ *    The AVX2 build feature enables vectorized block encoders and
+ *    decoders that convert between 24 bytes and 32 characters per
+ *    iteration. It is enabled by default whenever the compiler
+ *    targets AVX2 (for example, with -mavx2 or -march=native).
+ */
+#ifndef NLBASE64_USE_AVX2
+#if defined(__AVX2__)
+#define NLBASE64_USE_AVX2 1
+#else
+#define NLBASE64_USE_AVX2 0
+#endif
+#endif /* NLBASE64_USE_AVX2 */
+
+/**
+ *  @def NLBASE64_USE_LOOKUP_TABLES
+ *
+ *  @brief
+ *    The lookup tables build feature replaces the range checks of the
+ *    scalar encoder and decoder with precomputed tables: a 4096-entry,
+ *    8 KiB table that maps each 12-bit value to its two characters and
+ *    four 256-entry, 1 KiB tables that map each character of a group
+ *    directly to its bits in the decoded 24-bit value. This trades
+ *    12 KiB of read-only data for branch-free conversion on targets
+ *    without SIMD. It is selected with --enable-base64-lookup-tables.
+ */
+#ifndef NLBASE64_USE_LOOKUP_TABLES
+#define NLBASE64_USE_LOOKUP_TABLES 0
+#endif /* NLBASE64_USE_LOOKUP_TABLES */
+
+/*
+ * The number of characters or bytes the streaming encoder and decoder
+ * stage on the stack when they run whole groups through the block
+ * encoder or pass decoded blocks to a write function. Must be a
+ * multiple of 4.
+ */
+#define NLBASE64_STREAM_CHUNK_SIZE 256
+
+/*
+ * The number of characters the line-wrapping encoder stages on the
+ * stack before copying them out a line at a time. Must be a multiple
+ * of 4.
+ */
+#define NLBASE64_LINES_CHUNK_SIZE 1024
+
+/*
+ * The number of characters the CRC-fused decoders decode at a time
+ * before folding the bytes written into the CRC, small enough that
+ * those bytes are still in the L1 cache. Must be a multiple of 4.
+ */
+#define NLBASE64_CRC_CHUNK_SIZE 4096
+
+#if NLBASE64_USE_AVX2
+#include <immintrin.h>
+#elif NLBASE64_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Map between the last two characters of the standard alphabet and
+// those of the URL- and filename-safe alphabet of RFC 4648, section 5.
+
+static inline char nl_base64_to_url(char ch)
+{
+    return (ch == '+') ? '-' : (ch == '/') ? '_' : ch;
+}
+
+static inline char nl_base64_from_url(char ch)
+{
+    return (ch == '-') ? '+' : (ch == '_') ? '/' : ch;
+}
+
+#if NLBASE64_USE_LOOKUP_TABLES
+#define NLBASE64_CHAR(v)                                        \
+    ((v) < 26 ? 'A' + (v) :                                     \
+     (v) < 52 ? 'a' + ((v) - 26) :                              \
+     (v) < 62 ? '0' + ((v) - 52) :                              \
+     (v) == 62 ? '+' : '/')
+
+#define NLBASE64_VAL(c)                                         \
+    ((c) >= 'A' && (c) <= 'Z' ? (c) - 'A' :                     \
+     (c) >= 'a' && (c) <= 'z' ? (c) - 'a' + 26 :                \
+     (c) >= '0' && (c) <= '9' ? (c) - '0' + 52 :                \
+     (c) == '+' ? 62 :                                          \
+     (c) == '/' ? 63 : -1)
+
+// Set in a decode table entry for any character outside the alphabet.
+// It lies above the 24 bits of a decoded group, so OR-ing the entries
+// for all four characters of a group preserves it.
+
+#define NLBASE64_INVALID 0x01000000UL
+
+#define NLBASE64_PAIR(v) { NLBASE64_CHAR((v) >> 6), NLBASE64_CHAR((v) & 0x3F) }
+
+#define NLBASE64_DEC(c, s) \
+    (NLBASE64_VAL(c) < 0 ? NLBASE64_INVALID : (uint32_t)NLBASE64_VAL(c) << (s))
+
+#define NLBASE64_DEC18(c) NLBASE64_DEC(c, 18)
+#define NLBASE64_DEC12(c) NLBASE64_DEC(c, 12)
+#define NLBASE64_DEC6(c)  NLBASE64_DEC(c, 6)
+#define NLBASE64_DEC0(c)  NLBASE64_DEC(c, 0)
+
+static const char nl_base64_enc_pairs[4096][2] = {
+    NL_TABLE4096(NLBASE64_PAIR)
+};
+
+// Indexed by the position of the character within its group.
+
+static const uint32_t nl_base64_dec_table[4][256] = {
+    { NL_TABLE256(NLBASE64_DEC18) },
+    { NL_TABLE256(NLBASE64_DEC12) },
+    { NL_TABLE256(NLBASE64_DEC6)  },
+    { NL_TABLE256(NLBASE64_DEC0)  }
+};
+
+static char nl_base64_val_to_char(uint8_t val)
+{
+    // The low half of each pair whose high half is 'A' covers the
+    // whole alphabet.
+
+    return (val < 64) ? nl_base64_enc_pairs[val][1] : '=';
+}
+
+static uint8_t nl_base64_char_to_val(char ch)
+{
+    const uint32_t val = nl_base64_dec_table[3][(uint8_t)ch];
+
+    return (val & NLBASE64_INVALID) ? UINT8_MAX : val;
+}
+
+// Encode as many whole 3-byte groups as are available in the input,
+// two characters per table lookup. The table holds the standard
+// alphabet, so URL-safe output is mapped a character at a time.
+//
+// Returns the number of input bytes consumed; the number of characters
+// written is 4/3 of that.
+//
+static size_t nl_base64_encode_table(const uint8_t *in, size_t inLen, char *out, bool url)
+{
+    const uint8_t *inStart = in;
+
+    while (inLen >= 3)
+    {
+        const uint32_t group = ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2];
+        const char *hi = nl_base64_enc_pairs[group >> 12];
+        const char *lo = nl_base64_enc_pairs[group & 0xFFF];
+
+        if (url)
+        {
+            out[0] = nl_base64_to_url(hi[0]);
+            out[1] = nl_base64_to_url(hi[1]);
+            out[2] = nl_base64_to_url(lo[0]);
+            out[3] = nl_base64_to_url(lo[1]);
+        }
+        else
+        {
+            out[0] = hi[0];
+            out[1] = hi[1];
+            out[2] = lo[0];
+            out[3] = lo[1];
+        }
+
+        in += 3;
+        inLen -= 3;
+        out += 4;
+    }
+
+    return in - inStart;
+}
+
+// Decode as many whole, valid 4-character groups as are available in
+// the input. A group containing '=' padding or any other character
+// outside the alphabet is left to the scalar decoder.
+//
+// Exactly 3 bytes are written per 4 characters read, so this is safe
+// for in-place decoding.
+//
+// If url is set, the characters of the URL-safe alphabet are accepted
+// as well as those of the standard one.
+//
+// Returns the number of input characters consumed; the number of bytes
+// written is 3/4 of that.
+//
+static size_t nl_base64_decode_table(const char *in, size_t inLen, uint8_t *out, bool url)
+{
+    const char *inStart = in;
+
+    while (inLen >= 4)
+    {
+        const uint8_t c0 = url ? nl_base64_from_url(in[0]) : in[0];
+        const uint8_t c1 = url ? nl_base64_from_url(in[1]) : in[1];
+        const uint8_t c2 = url ? nl_base64_from_url(in[2]) : in[2];
+        const uint8_t c3 = url ? nl_base64_from_url(in[3]) : in[3];
+        const uint32_t group = nl_base64_dec_table[0][c0] |
+                               nl_base64_dec_table[1][c1] |
+                               nl_base64_dec_table[2][c2] |
+                               nl_base64_dec_table[3][c3];
+
+        if (group & NLBASE64_INVALID)
+            break;
+
+        out[0] = group >> 16;
+        out[1] = group >> 8;
+        out[2] = group;
+
+        in += 4;
+        inLen -= 4;
+        out += 3;
+    }
+
+    return in - inStart;
+}
+#else
 static char nl_base64_val_to_char(uint8_t val)
 {
     if (val < 26)
@@ -68,17 +305,226 @@ static uint8_t nl_base64_char_to_val(char ch)
         return val + 26;
     return UINT8_MAX;
 }
+#endif /* NLBASE64_USE_LOOKUP_TABLES */
 
-// Encode an array of bytes to a base64 string.
+static inline char nl_base64_alphabet_char(uint8_t val, bool url)
+{
+    const char ch = nl_base64_val_to_char(val);
+
+    return url ? nl_base64_to_url(ch) : ch;
+}
+
+// If url is set, accept the characters of either alphabet.
+
+static inline uint8_t nl_base64_alphabet_val(char ch, bool url)
+{
+    return nl_base64_char_to_val(url ? nl_base64_from_url(ch) : ch);
+}
+
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2
+/*
+ * The vector encoders below map each 6-bit value to its character by
+ * adding a per-range offset selected with compares rather than
+ * branches:
+ *
+ *   [ 0, 25] -> 'A' + val
+ *   [26, 51] -> 'a' + (val - 26)
+ *   [52, 61] -> '0' + (val - 52)
+ *   62       -> '+' or, in the URL-safe alphabet, '-'
+ *   63       -> '/' or, in the URL-safe alphabet, '_'
+ *
+ * Each offset below is expressed relative to the one for the preceding
+ * range so that the masked offsets simply accumulate.
+ */
+#define NLBASE64_OFFSET_UPPER    ('A')
+#define NLBASE64_OFFSET_LOWER    (('a' - 26) - ('A'))
+#define NLBASE64_OFFSET_DIGIT    (('0' - 52) - ('a' - 26))
+#define NLBASE64_OFFSET_62       (('+' - 62) - ('0' - 52))
+#define NLBASE64_OFFSET_63       (('/' - 63) - ('0' - 52))
+#define NLBASE64_OFFSET_62_URL   (('-' - 62) - ('0' - 52))
+#define NLBASE64_OFFSET_63_URL   (('_' - 63) - ('0' - 52))
+
+static inline uint32_t nl_base64_load24(const uint8_t *in)
+{
+    return ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2];
+}
+
+static inline __m128i nl_base64_sse2_translate(__m128i val, __m128i offset62, __m128i offset63)
+{
+    __m128i offset = _mm_set1_epi8(NLBASE64_OFFSET_UPPER);
+
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(val, _mm_set1_epi8(25)),
+                                                _mm_set1_epi8(NLBASE64_OFFSET_LOWER)));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(val, _mm_set1_epi8(51)),
+                                                _mm_set1_epi8(NLBASE64_OFFSET_DIGIT)));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(val, _mm_set1_epi8(62)), offset62));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(val, _mm_set1_epi8(63)), offset63));
+
+    return _mm_add_epi8(val, offset);
+}
+
+// Encode as many whole 12-byte groups as are available in the input,
+// four 3-byte groups at a time.
 //
-// Returns length of generated string.
-// Output DOES NOT include null terminator.
-// Output buffer must be at least (inLen + 3) * 4 / 3 bytes long.
-// Input and output buffers CANNOT overlap.
+// Returns the number of input bytes consumed; the number of characters
+// written is 4/3 of that.
 //
-uint16_t nl_base64_encode(const uint8_t *in, uint16_t inLen, char *out)
+static size_t nl_base64_encode_sse2(const uint8_t *in, size_t inLen, char *out, bool url)
+{
+    const uint8_t *inStart = in;
+    const __m128i offset62 = _mm_set1_epi8(url ? NLBASE64_OFFSET_62_URL : NLBASE64_OFFSET_62);
+    const __m128i offset63 = _mm_set1_epi8(url ? NLBASE64_OFFSET_63_URL : NLBASE64_OFFSET_63);
+
+    while (inLen >= 12)
+    {
+        // Each 32-bit lane receives one 24-bit group, which is then
+        // split into four 6-bit values, one per byte, in output order.
+
+        const __m128i group = _mm_setr_epi32(nl_base64_load24(in + 0),
+                                             nl_base64_load24(in + 3),
+                                             nl_base64_load24(in + 6),
+                                             nl_base64_load24(in + 9));
+        __m128i val;
+
+        val = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(group, 18),
+                                        _mm_and_si128(_mm_srli_epi32(group, 4),
+                                                      _mm_set1_epi32(0x00003F00))),
+                           _mm_or_si128(_mm_and_si128(_mm_slli_epi32(group, 10),
+                                                      _mm_set1_epi32(0x003F0000)),
+                                        _mm_and_si128(_mm_slli_epi32(group, 24),
+                                                      _mm_set1_epi32(0x3F000000))));
+
+        _mm_storeu_si128((__m128i *)out, nl_base64_sse2_translate(val, offset62, offset63));
+
+        in += 12;
+        inLen -= 12;
+        out += 16;
+    }
+
+    return in - inStart;
+}
+#endif /* NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2 */
+
+#if NLBASE64_USE_AVX2
+static inline __m256i nl_base64_avx2_translate(__m256i val, __m256i offset62, __m256i offset63)
+{
+    __m256i offset = _mm256_set1_epi8(NLBASE64_OFFSET_UPPER);
+
+    offset = _mm256_add_epi8(offset, _mm256_and_si256(_mm256_cmpgt_epi8(val, _mm256_set1_epi8(25)),
+                                                      _mm256_set1_epi8(NLBASE64_OFFSET_LOWER)));
+    offset = _mm256_add_epi8(offset, _mm256_and_si256(_mm256_cmpgt_epi8(val, _mm256_set1_epi8(51)),
+                                                      _mm256_set1_epi8(NLBASE64_OFFSET_DIGIT)));
+    offset = _mm256_add_epi8(offset, _mm256_and_si256(_mm256_cmpeq_epi8(val, _mm256_set1_epi8(62)), offset62));
+    offset = _mm256_add_epi8(offset, _mm256_and_si256(_mm256_cmpeq_epi8(val, _mm256_set1_epi8(63)), offset63));
+
+    return _mm256_add_epi8(val, offset);
+}
+
+// Encode as many whole 24-byte groups as are available in the input,
+// eight 3-byte groups at a time.
+//
+// Each iteration loads 16 bytes at offsets 0 and 12, so it runs only
+// while at least 28 input bytes remain to avoid reading past the end
+// of the input.
+//
+// Returns the number of input bytes consumed; the number of characters
+// written is 4/3 of that.
+//
+static size_t nl_base64_encode_avx2(const uint8_t *in, size_t inLen, char *out, bool url)
+{
+    const uint8_t *inStart = in;
+    const __m256i offset62 = _mm256_set1_epi8(url ? NLBASE64_OFFSET_62_URL : NLBASE64_OFFSET_62);
+    const __m256i offset63 = _mm256_set1_epi8(url ? NLBASE64_OFFSET_63_URL : NLBASE64_OFFSET_63);
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+    while (inLen >= 28)
+    {
+        __m256i group, hi, lo;
+
+        group = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + 0))),
+                                        _mm_loadu_si128((const __m128i *)(in + 12)), 1);
+
+        // Arrange each 3-byte group as [b1 b0 b2 b1] in its 32-bit
+        // lane, then use 16-bit multiplies to shift all four 6-bit
+        // fields into the low bits of their respective bytes.
+
+        group = _mm256_shuffle_epi8(group, shuffle);
+
+        hi = _mm256_mulhi_epu16(_mm256_and_si256(group, _mm256_set1_epi32(0x0FC0FC00)),
+                                _mm256_set1_epi32(0x04000040));
+        lo = _mm256_mullo_epi16(_mm256_and_si256(group, _mm256_set1_epi32(0x003F03F0)),
+                                _mm256_set1_epi32(0x01000010));
+
+        _mm256_storeu_si256((__m256i *)out, nl_base64_avx2_translate(_mm256_or_si256(hi, lo), offset62, offset63));
+
+        in += 24;
+        inLen -= 24;
+        out += 32;
+    }
+
+    return in - inStart;
+}
+#endif /* NLBASE64_USE_AVX2 */
+
+// Return the exact length of the string that encoding inLen bytes
+// produces, with or without padding, not including any null terminator.
+//
+size_t nl_base64_encoded_len(size_t inLen, bool pad)
+{
+    const size_t remainder = inLen % 3;
+    size_t len = (inLen / 3) * 4;
+
+    if (remainder != 0)
+        len += pad ? 4 : remainder + 1;
+
+    return len;
+}
+
+// Return the exact number of bytes that decoding a well-formed, padded or
+// unpadded, base64 string of inLen characters produces. For malformed
+// input, the result is an upper bound on the number of bytes that
+// nl_base64_decode_ex writes before it reports an error.
+//
+size_t nl_base64_decoded_len(const char *in, size_t inLen)
+{
+    if (inLen > 0 && in[inLen - 1] == '=')
+        inLen--;
+    if (inLen > 0 && in[inLen - 1] == '=')
+        inLen--;
+
+    return (inLen / 4) * 3 + ((inLen % 4) * 3) / 4;
+}
+
+// Encode in the standard or URL-safe alphabet, with or without padding.
+//
+static size_t nl_base64_encode_alphabet(const uint8_t *in, size_t inLen, char *out, bool url, bool pad)
 {
     char *outStart = out;
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2 || NLBASE64_USE_LOOKUP_TABLES
+    size_t consumed;
+#endif
+
+#if NLBASE64_USE_AVX2
+    consumed = nl_base64_encode_avx2(in, inLen, out, url);
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 3 * 4;
+#endif
+
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2
+    consumed = nl_base64_encode_sse2(in, inLen, out, url);
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 3 * 4;
+#endif
+
+#if NLBASE64_USE_LOOKUP_TABLES
+    consumed = nl_base64_encode_table(in, inLen, out, url);
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 3 * 4;
+#endif
 
     while (inLen > 0)
     {
@@ -107,114 +553,1060 @@ uint16_t nl_base64_encode(const uint8_t *in, uint16_t inLen, char *out)
         else
             val3 = val4 = UINT8_MAX;
 
-        *out++ = nl_base64_val_to_char(val1);
-        *out++ = nl_base64_val_to_char(val2);
-        *out++ = nl_base64_val_to_char(val3);
-        *out++ = nl_base64_val_to_char(val4);
+        *out++ = nl_base64_alphabet_char(val1, url);
+        *out++ = nl_base64_alphabet_char(val2, url);
+
+        if (pad || val3 != UINT8_MAX)
+            *out++ = nl_base64_alphabet_char(val3, url);
+
+        if (pad || val4 != UINT8_MAX)
+            *out++ = nl_base64_alphabet_char(val4, url);
     }
 
     return out - outStart;
 }
 
-// Decode a base64 string to byte.
+// Encode an array of bytes to a base64 string.
 //
-// Supports decode in place by setting out pointer equal to in.  UINT16_MAX returned on err.
+// Returns length of generated string.
+// Output DOES NOT include null terminator.
+// Output buffer must be at least nl_base64_encoded_len(inLen, true) bytes long.
+// Input and output buffers CANNOT overlap.
 //
-uint16_t nl_base64_decode(const char *in, uint16_t inLen, uint8_t *out)
+size_t nl_base64_encode_ex(const uint8_t *in, size_t inLen, char *out)
 {
-    uint8_t *outStart = out;
+    return nl_base64_encode_alphabet(in, inLen, out, false, true);
+}
 
-    while (inLen > 0)
+// Encode as above, in the URL-safe alphabet if NLBASE64_FLAG_URL_SAFE is
+// set and without padding if NLBASE64_FLAG_NO_PADDING is set, in which
+// case the output buffer need only be nl_base64_encoded_len(inLen, false)
+// bytes long.
+//
+size_t nl_base64_encode_flags(const uint8_t *in, size_t inLen, char *out, uint8_t flags)
+{
+    return nl_base64_encode_alphabet(in, inLen, out,
+                                     (flags & NLBASE64_FLAG_URL_SAFE) != 0,
+                                     (flags & NLBASE64_FLAG_NO_PADDING) == 0);
+}
+
+// Encode the concatenation of num_segments segments, carrying the 0 to 2
+// bytes left over at the end of each segment into the first group of the
+// next, and running the whole groups in between through the block
+// encoder straight from the segment.
+//
+// Returns the length of the generated string.
+//
+size_t nl_base64_encode_segments(const nl_base64_segment_t *segments, size_t num_segments,
+                                 char *out, uint8_t flags)
+{
+    const bool url = (flags & NLBASE64_FLAG_URL_SAFE) != 0;
+    const bool pad = (flags & NLBASE64_FLAG_NO_PADDING) == 0;
+    char * const outStart = out;
+    uint8_t carry[3];
+    size_t num_carried = 0;
+    size_t i;
+
+    for (i = 0; i < num_segments; i++)
     {
-        if (inLen == 1)
-            return UINT16_MAX;
+        const uint8_t *in = (const uint8_t *)segments[i].data;
+        size_t inLen = segments[i].length;
+        size_t whole;
 
-        uint8_t a = nl_base64_char_to_val(*in++);
-        uint8_t b = nl_base64_char_to_val(*in++);
-        inLen -= 2;
+        if (num_carried > 0)
+        {
+            while (num_carried < 3 && inLen > 0)
+            {
+                carry[num_carried++] = *in++;
+                inLen--;
+            }
 
-        if (a == UINT8_MAX || b == UINT8_MAX)
-            return UINT16_MAX;
+            if (num_carried < 3)
+                continue;
 
-        *out++ = (a << 2) | (b >> 4);
+            out += nl_base64_encode_alphabet(carry, 3, out, url, pad);
+            num_carried = 0;
+        }
 
-        if (inLen == 0 || *in == '=')
-            break;
+        whole = inLen - inLen % 3;
 
-        uint8_t c = nl_base64_char_to_val(*in++);
-        inLen--;
+        out += nl_base64_encode_alphabet(in, whole, out, url, pad);
 
-        if (c == UINT8_MAX)
-            return UINT16_MAX;
+        while (whole < inLen)
+            carry[num_carried++] = in[whole++];
+    }
 
-        *out++ = (b << 4) | (c >> 2);
+    out += nl_base64_encode_alphabet(carry, num_carried, out, url, pad);
 
-        if (inLen == 0 || *in == '=')
-            break;
+    return out - outStart;
+}
 
-        uint8_t d = nl_base64_char_to_val(*in++);
-        inLen--;
+// Encode the inLen bytes at the start of inOut in place, working back
+// from the end so that output never overtakes unread input.
+//
+// A chunk [start, end) whose output starts at or after end can be
+// encoded directly, which holds whenever start >= 3/4 end. So each pass
+// encodes the last quarter of what remains, and the first few groups,
+// for which that quarter is too small to be worthwhile, are staged on
+// the stack.
+//
+// Returns the length of the generated string.
+//
+size_t nl_base64_encode_in_place(uint8_t *inOut, size_t inLen, uint8_t flags)
+{
+    const bool url = (flags & NLBASE64_FLAG_URL_SAFE) != 0;
+    const bool pad = (flags & NLBASE64_FLAG_NO_PADDING) == 0;
+    char stage[NLBASE64_STREAM_CHUNK_SIZE];
+    size_t end = inLen;
 
-        if (d == UINT8_MAX)
-            return UINT16_MAX;
+    while (end > sizeof (stage) / 4 * 3)
+    {
+        // The smallest multiple of 3 no less than 3/4 of end. Only the
+        // first chunk can end in a partial group.
 
-        *out++ = (c << 6) | d;
+        size_t start = end - end / 4;
+
+        start = (start + 2) / 3 * 3;
+
+        nl_base64_encode_alphabet(inOut + start, end - start, (char *)inOut + start / 3 * 4, url, pad);
+
+        end = start;
     }
 
-    return out - outStart;
+    if (end > 0)
+        memcpy(inOut, stage, nl_base64_encode_alphabet(inOut, end, stage, url, pad));
+
+    return nl_base64_encoded_len(inLen, pad);
 }
 
-//
-// Encode Base64 in O(1) space
-//
-void nl_base64_stream_enc_start(nl_base64_stream_enc_state_t *state, nl_base64_stream_enc_putchar_t out_putchar, void *context)
+size_t nl_base64_encoded_lines_len(size_t inLen, size_t line_length, size_t terminator_length)
 {
-    state->num_encoded = 0;
-    state->num_written = 0;
-    state->putchar     = out_putchar;
-    state->context     = context;
+    const size_t len = nl_base64_encoded_len(inLen, true);
+
+    if (line_length == 0)
+        return len;
+
+    return len + (len / line_length + (len % line_length != 0)) * terminator_length;
 }
 
-uint16_t nl_base64_stream_enc_more(const uint8_t *in, uint16_t inLen,
-                                   nl_base64_stream_enc_state_t *state)
+// Encode with padding, ending every line of line_length characters, and
+// the last line, with the terminator.
+//
+// Returns the number of characters written, including terminators.
+//
+size_t nl_base64_encode_lines(const uint8_t *in, size_t inLen, char *out,
+                              size_t line_length, const char *terminator)
 {
-    const uint16_t was_written = state->num_written;
+    const size_t terminator_length = strlen(terminator);
+    char chunk[NLBASE64_LINES_CHUNK_SIZE];
+    char *outStart = out;
+    size_t column = 0;
+
+    if (line_length == 0)
+        return nl_base64_encode_ex(in, inLen, out);
+
+    // Encode a chunk at a time, so that the vector encoders run over
+    // many lines at once, and copy it out a line at a time.
 
     while (inLen > 0)
     {
-        switch (state->num_encoded)
+        const char *cursor = chunk;
+        const size_t consumed = (inLen < sizeof (chunk) / 4 * 3) ? inLen : sizeof (chunk) / 4 * 3;
+        size_t produced = nl_base64_encode_ex(in, consumed, chunk);
+
+        while (produced > 0)
         {
-        case 0:
-            state->encoded[0] = *in >> 2;
-            state->encoded[1] = (*in << 4) & 0x3F;
-            state->num_encoded++;
-            break;
-        case 1:
-            state->encoded[1] |= *in >> 4;
-            state->encoded[2] =  (*in << 2) & 0x3F;
-            state->num_encoded++;
-            break;
-        case 2:
-            state->encoded[2] |= *in >> 6;
-            state->putchar(nl_base64_val_to_char(state->encoded[0]), state->context);
-            state->putchar(nl_base64_val_to_char(state->encoded[1]), state->context);
-            state->putchar(nl_base64_val_to_char(state->encoded[2]), state->context);
-            state->putchar(nl_base64_val_to_char(*in & 0x3F), state->context);
-            state->num_encoded = 0;
-            state->num_written += 4;
-            break;
-        default:
-            assert(state->num_encoded <= 2); // Not possible
-            break;
-        }
+            size_t run = line_length - column;
+
+            if (run > produced)
+                run = produced;
+
+            memcpy(out, cursor, run);
+            out += run;
+            cursor += run;
+            produced -= run;
+            column += run;
+
+            if (column == line_length)
+            {
+                memcpy(out, terminator, terminator_length);
+                out += terminator_length;
+                column = 0;
+            }
+        }
+
+        in += consumed;
+        inLen -= consumed;
+    }
+
+    if (column != 0)
+    {
+        memcpy(out, terminator, terminator_length);
+        out += terminator_length;
+    }
+
+    return out - outStart;
+}
+
+uint16_t nl_base64_encode(const uint8_t *in, uint16_t inLen, char *out)
+{
+    return nl_base64_encode_ex(in, inLen, out);
+}
+
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2
+/*
+ * The vector decoders below map each character to its 6-bit value by
+ * adding a per-range offset, and at the same time accumulate a mask
+ * of the lanes that fell into any valid range. Any lane outside the
+ * alphabet, including '=' padding, stops the vector loop and leaves
+ * that group to the scalar decoder, which either handles the padding
+ * or rejects the input.
+ */
+#define NLBASE64_RANGE_SSE2(c, lo, hi) \
+    _mm_and_si128(_mm_cmpgt_epi8((c), _mm_set1_epi8((lo) - 1)), _mm_cmpgt_epi8(_mm_set1_epi8((hi) + 1), (c)))
+
+// If url is set, '-' and '_' are accepted for 62 and 63 alongside '+'
+// and '/'. Callers pass a constant, so that the standard alphabet pays
+// nothing for the extra compares.
+//
+static inline __m128i nl_base64_sse2_untranslate(__m128i c, bool url, int *valid)
+{
+    const __m128i upper = NLBASE64_RANGE_SSE2(c, 'A', 'Z');
+    const __m128i lower = NLBASE64_RANGE_SSE2(c, 'a', 'z');
+    const __m128i digit = NLBASE64_RANGE_SSE2(c, '0', '9');
+    __m128i val62 = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+    __m128i val63 = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+    __m128i offset;
+
+    offset = _mm_or_si128(_mm_and_si128(val62, _mm_set1_epi8(62 - '+')),
+                          _mm_and_si128(val63, _mm_set1_epi8(63 - '/')));
+
+    if (url)
+    {
+        const __m128i minus      = _mm_cmpeq_epi8(c, _mm_set1_epi8('-'));
+        const __m128i underscore = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+
+        offset = _mm_or_si128(offset, _mm_or_si128(_mm_and_si128(minus, _mm_set1_epi8(62 - '-')),
+                                                   _mm_and_si128(underscore, _mm_set1_epi8(63 - '_'))));
+        val62 = _mm_or_si128(val62, minus);
+        val63 = _mm_or_si128(val63, underscore);
+    }
+
+    *valid = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower),
+                                            _mm_or_si128(_mm_or_si128(digit, val62), val63))) == 0xFFFF;
+
+    offset = _mm_or_si128(_mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(0 - 'A')),
+                                       _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+                          _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')), offset));
+
+    return _mm_add_epi8(c, offset);
+}
+
+// Decode as many whole, valid 16-character groups as are available in
+// the input.
+//
+// Exactly 12 bytes are written per 16 characters read, so this is safe
+// for in-place decoding.
+//
+// Returns the number of input characters consumed; the number of bytes
+// written is 3/4 of that.
+//
+static inline size_t nl_base64_decode_sse2_alphabet(const char *in, size_t inLen, uint8_t *out, bool url)
+{
+    const char *inStart = in;
+
+    while (inLen >= 16)
+    {
+        uint32_t group[4];
+        __m128i val;
+        int valid;
+        int i;
+
+        val = nl_base64_sse2_untranslate(_mm_loadu_si128((const __m128i *)in), url, &valid);
+
+        if (!valid)
+            break;
+
+        // Merge adjacent 6-bit values into 12-bit values in each 16-bit
+        // lane, and then adjacent 12-bit values into 24-bit values in
+        // each 32-bit lane.
+
+        val = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(val, _mm_set1_epi16(0x00FF)), 6),
+                           _mm_srli_epi16(val, 8));
+        val = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(val, _mm_set1_epi32(0x0000FFFF)), 12),
+                           _mm_srli_epi32(val, 16));
+
+        _mm_storeu_si128((__m128i *)group, val);
+
+        for (i = 0; i < 4; i++)
+        {
+            *out++ = group[i] >> 16;
+            *out++ = group[i] >> 8;
+            *out++ = group[i];
+        }
+
+        in += 16;
+        inLen -= 16;
+    }
+
+    return in - inStart;
+}
+
+static size_t nl_base64_decode_sse2(const char *in, size_t inLen, uint8_t *out, bool url)
+{
+    return url ? nl_base64_decode_sse2_alphabet(in, inLen, out, true) :
+                 nl_base64_decode_sse2_alphabet(in, inLen, out, false);
+}
+
+// Return a mask with all bits of each lane set if it holds a character
+// of the alphabet, without translating it.
+//
+static inline __m128i nl_base64_sse2_valid(__m128i c, bool url)
+{
+    __m128i valid = _mm_or_si128(_mm_or_si128(NLBASE64_RANGE_SSE2(c, 'A', 'Z'),
+                                              NLBASE64_RANGE_SSE2(c, 'a', 'z')),
+                                 _mm_or_si128(NLBASE64_RANGE_SSE2(c, '0', '9'),
+                                              _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('+')),
+                                                           _mm_cmpeq_epi8(c, _mm_set1_epi8('/')))));
+
+    if (url)
+        valid = _mm_or_si128(valid, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')),
+                                                 _mm_cmpeq_epi8(c, _mm_set1_epi8('_'))));
+
+    return valid;
+}
+
+// Skip as many 16-character blocks made up entirely of the alphabet as
+// are available in the input, four at a time while possible.
+//
+// Returns the number of input characters skipped.
+//
+static inline size_t nl_base64_validate_sse2_alphabet(const char *in, size_t inLen, bool url)
+{
+    const char *inStart = in;
+
+    while (inLen >= 64)
+    {
+        const __m128i valid = _mm_and_si128(
+            _mm_and_si128(nl_base64_sse2_valid(_mm_loadu_si128((const __m128i *)in), url),
+                          nl_base64_sse2_valid(_mm_loadu_si128((const __m128i *)(in + 16)), url)),
+            _mm_and_si128(nl_base64_sse2_valid(_mm_loadu_si128((const __m128i *)(in + 32)), url),
+                          nl_base64_sse2_valid(_mm_loadu_si128((const __m128i *)(in + 48)), url)));
+
+        if (_mm_movemask_epi8(valid) != 0xFFFF)
+            break;
+
+        in += 64;
+        inLen -= 64;
+    }
+
+    while (inLen >= 16)
+    {
+        if (_mm_movemask_epi8(nl_base64_sse2_valid(_mm_loadu_si128((const __m128i *)in), url)) != 0xFFFF)
+            break;
+
+        in += 16;
+        inLen -= 16;
+    }
+
+    return in - inStart;
+}
+
+static size_t nl_base64_validate_sse2(const char *in, size_t inLen, bool url)
+{
+    return url ? nl_base64_validate_sse2_alphabet(in, inLen, true) :
+                 nl_base64_validate_sse2_alphabet(in, inLen, false);
+}
+#endif /* NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2 */
+
+#if NLBASE64_USE_AVX2
+#define NLBASE64_RANGE_AVX2(c, lo, hi) \
+    _mm256_and_si256(_mm256_cmpgt_epi8((c), _mm256_set1_epi8((lo) - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8((hi) + 1), (c)))
+
+static inline __m256i nl_base64_avx2_untranslate(__m256i c, bool url, int *valid)
+{
+    const __m256i upper = NLBASE64_RANGE_AVX2(c, 'A', 'Z');
+    const __m256i lower = NLBASE64_RANGE_AVX2(c, 'a', 'z');
+    const __m256i digit = NLBASE64_RANGE_AVX2(c, '0', '9');
+    __m256i val62 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+'));
+    __m256i val63 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'));
+    __m256i offset;
+
+    offset = _mm256_or_si256(_mm256_and_si256(val62, _mm256_set1_epi8(62 - '+')),
+                             _mm256_and_si256(val63, _mm256_set1_epi8(63 - '/')));
+
+    if (url)
+    {
+        const __m256i minus      = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-'));
+        const __m256i underscore = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+
+        offset = _mm256_or_si256(offset, _mm256_or_si256(_mm256_and_si256(minus, _mm256_set1_epi8(62 - '-')),
+                                                         _mm256_and_si256(underscore, _mm256_set1_epi8(63 - '_'))));
+        val62 = _mm256_or_si256(val62, minus);
+        val63 = _mm256_or_si256(val63, underscore);
+    }
+
+    *valid = _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(upper, lower),
+                                                  _mm256_or_si256(_mm256_or_si256(digit, val62), val63))) == -1;
+
+    offset = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(0 - 'A')),
+                                             _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+                             _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')), offset));
+
+    return _mm256_add_epi8(c, offset);
+}
+
+// Decode as many whole, valid 32-character groups as are available in
+// the input.
+//
+// Exactly 24 bytes are written per 32 characters read, so this is safe
+// for in-place decoding.
+//
+// Returns the number of input characters consumed; the number of bytes
+// written is 3/4 of that.
+//
+static inline size_t nl_base64_decode_avx2_alphabet(const char *in, size_t inLen, uint8_t *out, bool url)
+{
+    const char *inStart = in;
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                             2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+    while (inLen >= 32)
+    {
+        __m256i val;
+        int valid;
+
+        val = nl_base64_avx2_untranslate(_mm256_loadu_si256((const __m256i *)in), url, &valid);
+
+        if (!valid)
+            break;
+
+        // Merge the four 6-bit values of each 32-bit lane into a 24-bit
+        // value, put its bytes in output order, and then close the
+        // 4-byte gaps between lanes so that 24 bytes are contiguous.
+
+        val = _mm256_maddubs_epi16(val, _mm256_set1_epi32(0x01400140));
+        val = _mm256_madd_epi16(val, _mm256_set1_epi32(0x00011000));
+        val = _mm256_shuffle_epi8(val, shuffle);
+        val = _mm256_permutevar8x32_epi32(val, permute);
+
+        _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(val));
+        _mm_storel_epi64((__m128i *)(out + 16), _mm256_extracti128_si256(val, 1));
+
+        in += 32;
+        inLen -= 32;
+        out += 24;
+    }
+
+    return in - inStart;
+}
+
+static size_t nl_base64_decode_avx2(const char *in, size_t inLen, uint8_t *out, bool url)
+{
+    return url ? nl_base64_decode_avx2_alphabet(in, inLen, out, true) :
+                 nl_base64_decode_avx2_alphabet(in, inLen, out, false);
+}
+
+static inline __m256i nl_base64_avx2_valid(__m256i c, bool url)
+{
+    __m256i valid = _mm256_or_si256(_mm256_or_si256(NLBASE64_RANGE_AVX2(c, 'A', 'Z'),
+                                                    NLBASE64_RANGE_AVX2(c, 'a', 'z')),
+                                    _mm256_or_si256(NLBASE64_RANGE_AVX2(c, '0', '9'),
+                                                    _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('+')),
+                                                                    _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/')))));
+
+    if (url)
+        valid = _mm256_or_si256(valid, _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')),
+                                                       _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'))));
+
+    return valid;
+}
+
+static inline size_t nl_base64_validate_avx2_alphabet(const char *in, size_t inLen, bool url)
+{
+    const char *inStart = in;
+
+    while (inLen >= 128)
+    {
+        const __m256i valid = _mm256_and_si256(
+            _mm256_and_si256(nl_base64_avx2_valid(_mm256_loadu_si256((const __m256i *)in), url),
+                             nl_base64_avx2_valid(_mm256_loadu_si256((const __m256i *)(in + 32)), url)),
+            _mm256_and_si256(nl_base64_avx2_valid(_mm256_loadu_si256((const __m256i *)(in + 64)), url),
+                             nl_base64_avx2_valid(_mm256_loadu_si256((const __m256i *)(in + 96)), url)));
+
+        if (_mm256_movemask_epi8(valid) != -1)
+            break;
+
+        in += 128;
+        inLen -= 128;
+    }
+
+    while (inLen >= 32)
+    {
+        if (_mm256_movemask_epi8(nl_base64_avx2_valid(_mm256_loadu_si256((const __m256i *)in), url)) != -1)
+            break;
+
+        in += 32;
+        inLen -= 32;
+    }
+
+    return in - inStart;
+}
+
+static size_t nl_base64_validate_avx2(const char *in, size_t inLen, bool url)
+{
+    return url ? nl_base64_validate_avx2_alphabet(in, inLen, true) :
+                 nl_base64_validate_avx2_alphabet(in, inLen, false);
+}
+#endif /* NLBASE64_USE_AVX2 */
+
+// Decode as many whole, valid 4-character groups as the enabled vector
+// and table decoders accept, stopping at the first group that contains
+// '=' padding or any other character outside the alphabet.
+//
+// Returns the number of input characters consumed; the number of bytes
+// written is 3/4 of that.
+//
+static size_t nl_base64_decode_groups(const char *in, size_t inLen, uint8_t *out, bool url)
+{
+    const char *inStart = in;
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2 || NLBASE64_USE_LOOKUP_TABLES
+    size_t consumed;
+#else
+    NL_UNUSED(inLen);
+    NL_UNUSED(out);
+    NL_UNUSED(url);
+#endif
+
+#if NLBASE64_USE_AVX2
+    consumed = nl_base64_decode_avx2(in, inLen, out, url);
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 4 * 3;
+#endif
+
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2
+    consumed = nl_base64_decode_sse2(in, inLen, out, url);
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 4 * 3;
+#endif
+
+#if NLBASE64_USE_LOOKUP_TABLES
+    consumed = nl_base64_decode_table(in, inLen, out, url);
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 4 * 3;
+#endif
+
+    return in - inStart;
+}
+
+// Decode in the standard alphabet or, if url is set, in either alphabet.
+//
+static size_t nl_base64_decode_alphabet(const char *in, size_t inLen, uint8_t *out, bool url)
+{
+    uint8_t *outStart = out;
+    const size_t consumed = nl_base64_decode_groups(in, inLen, out, url);
+
+    in += consumed;
+    inLen -= consumed;
+    out += consumed / 4 * 3;
+
+    while (inLen > 0)
+    {
+        if (inLen == 1)
+            return SIZE_MAX;
+
+        uint8_t a = nl_base64_alphabet_val(*in++, url);
+        uint8_t b = nl_base64_alphabet_val(*in++, url);
+        inLen -= 2;
+
+        if (a == UINT8_MAX || b == UINT8_MAX)
+            return SIZE_MAX;
+
+        *out++ = (a << 2) | (b >> 4);
+
+        if (inLen == 0 || *in == '=')
+            break;
+
+        uint8_t c = nl_base64_alphabet_val(*in++, url);
+        inLen--;
+
+        if (c == UINT8_MAX)
+            return SIZE_MAX;
+
+        *out++ = (b << 4) | (c >> 2);
+
+        if (inLen == 0 || *in == '=')
+            break;
+
+        uint8_t d = nl_base64_alphabet_val(*in++, url);
+        inLen--;
+
+        if (d == UINT8_MAX)
+            return SIZE_MAX;
+
+        *out++ = (c << 6) | d;
+    }
+
+    return out - outStart;
+}
+
+// Check a base64 string as nl_base64_decode_flags would decode it, with
+// the vector scanners skipping the leading run of alphabet characters
+// and the rest following the scalar decoder group by group.
+//
+// Returns the number of bytes the string decodes to, or SIZE_MAX if it is
+// malformed.
+//
+size_t nl_base64_validate(const char *in, size_t inLen, uint8_t flags)
+{
+    const bool url = (flags & NLBASE64_FLAG_URL_SAFE) != 0;
+    size_t outLen = 0;
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2
+    size_t consumed;
+#endif
+
+#if NLBASE64_USE_AVX2
+    consumed = nl_base64_validate_avx2(in, inLen, url);
+    in += consumed;
+    inLen -= consumed;
+    outLen += consumed / 4 * 3;
+#endif
+
+#if NLBASE64_USE_SSE2 || NLBASE64_USE_AVX2
+    consumed = nl_base64_validate_sse2(in, inLen, url);
+    in += consumed;
+    inLen -= consumed;
+    outLen += consumed / 4 * 3;
+#endif
+
+    while (inLen > 0)
+    {
+        if (inLen == 1)
+            return SIZE_MAX;
+
+        if (nl_base64_alphabet_val(in[0], url) == UINT8_MAX ||
+            nl_base64_alphabet_val(in[1], url) == UINT8_MAX)
+            return SIZE_MAX;
+
+        outLen++;
+
+        if (inLen == 2 || in[2] == '=')
+            break;
+
+        if (nl_base64_alphabet_val(in[2], url) == UINT8_MAX)
+            return SIZE_MAX;
+
+        outLen++;
+
+        if (inLen == 3 || in[3] == '=')
+            break;
+
+        if (nl_base64_alphabet_val(in[3], url) == UINT8_MAX)
+            return SIZE_MAX;
+
+        outLen++;
+        in += 4;
+        inLen -= 4;
+    }
+
+    return outLen;
+}
+
+// Decode a base64 string to byte.
+//
+// Supports decode in place by setting out pointer equal to in.  SIZE_MAX returned on err.
+//
+size_t nl_base64_decode_ex(const char *in, size_t inLen, uint8_t *out)
+{
+    return nl_base64_decode_alphabet(in, inLen, out, false);
+}
+
+// Decode as above, accepting the URL-safe alphabet as well as the
+// standard one, even mixed, if NLBASE64_FLAG_URL_SAFE is set. Padding is
+// optional either way.
+//
+size_t nl_base64_decode_flags(const char *in, size_t inLen, uint8_t *out, uint8_t flags)
+{
+    return nl_base64_decode_alphabet(in, inLen, out, (flags & NLBASE64_FLAG_URL_SAFE) != 0);
+}
+
+// Decode as nl_base64_decode_flags does, folding the decoded bytes into
+// *crc with crc_update a chunk at a time, right after each chunk is
+// written, rather than in a second pass over the whole output.
+//
+// Supports decode in place. SIZE_MAX returned on err, in which case *crc
+// is left unchanged.
+//
+size_t nl_base64_decode_crc(const char *in, size_t inLen, uint8_t *out, uint8_t flags,
+                            nl_base64_crc_update_t crc_update, uint32_t *crc)
+{
+    const bool url = (flags & NLBASE64_FLAG_URL_SAFE) != 0;
+    uint32_t sum = *crc;
+    size_t outLen = 0;
+
+    while (inLen > 0)
+    {
+        const size_t len = (inLen < NLBASE64_CRC_CHUNK_SIZE) ? inLen : NLBASE64_CRC_CHUNK_SIZE;
+        const size_t decoded = nl_base64_decode_alphabet(in, len, out, url);
+
+        if (decoded == SIZE_MAX)
+            return SIZE_MAX;
+
+        sum = crc_update(sum, out, decoded);
+        outLen += decoded;
+
+        // Every chunk but the last is whole groups, so anything short of
+        // them means padding, which ends the input.
+
+        if (decoded != len / 4 * 3)
+            break;
+
+        in += len;
+        inLen -= len;
+        out += decoded;
+    }
+
+    *crc = sum;
+
+    return outLen;
+}
+
+uint16_t nl_base64_decode(const char *in, uint16_t inLen, uint8_t *out)
+{
+    const size_t result = nl_base64_decode_ex(in, inLen, out);
+
+    return (result == SIZE_MAX) ? UINT16_MAX : result;
+}
+
+//
+// Encode Base64 in O(1) space
+//
+void nl_base64_stream_enc_start(nl_base64_stream_enc_state_t *state, nl_base64_stream_enc_putchar_t out_putchar, void *context)
+{
+    state->num_encoded = 0;
+    state->num_written = 0;
+    state->putchar     = out_putchar;
+    state->context     = context;
+}
+
+uint16_t nl_base64_stream_enc_more(const uint8_t *in, uint16_t inLen,
+                                   nl_base64_stream_enc_state_t *state)
+{
+    const uint16_t was_written = state->num_written;
+
+    while (inLen > 0)
+    {
+        switch (state->num_encoded)
+        {
+        case 0:
+            state->encoded[0] = *in >> 2;
+            state->encoded[1] = (*in << 4) & 0x3F;
+            state->num_encoded++;
+            break;
+        case 1:
+            state->encoded[1] |= *in >> 4;
+            state->encoded[2] =  (*in << 2) & 0x3F;
+            state->num_encoded++;
+            break;
+        case 2:
+            state->encoded[2] |= *in >> 6;
+            state->putchar(nl_base64_val_to_char(state->encoded[0]), state->context);
+            state->putchar(nl_base64_val_to_char(state->encoded[1]), state->context);
+            state->putchar(nl_base64_val_to_char(state->encoded[2]), state->context);
+            state->putchar(nl_base64_val_to_char(*in & 0x3F), state->context);
+            state->num_encoded = 0;
+            state->num_written += 4;
+            break;
+        default:
+            assert(state->num_encoded <= 2); // Not possible
+            break;
+        }
+        in++;
+        inLen--;
+    }
+
+    return (state->num_written - was_written);
+}
+
+uint16_t nl_base64_stream_enc_finish(bool pad, nl_base64_stream_enc_state_t *state)
+{
+    switch (state->num_encoded)
+    {
+    case 0:
+    default:
+        break;
+    case 1:
+        state->putchar(nl_base64_val_to_char(state->encoded[0]), state->context);
+        state->putchar(nl_base64_val_to_char(state->encoded[1]), state->context);
+        state->num_written += 2;
+        if (pad)
+        {
+            state->putchar('=', state->context);
+            state->putchar('=', state->context);
+            state->num_written += 2;
+        }
+        break;
+    case 2:
+        state->putchar(nl_base64_val_to_char(state->encoded[0]), state->context);
+        state->putchar(nl_base64_val_to_char(state->encoded[1]), state->context);
+        state->putchar(nl_base64_val_to_char(state->encoded[2]), state->context);
+        state->num_written += 3;
+        if (pad)
+        {
+            state->putchar('=', state->context);
+            state->num_written += 1;
+        }
+        break;
+    }
+
+    return state->num_written;
+}
+
+//
+// Encode Base64 in O(1) space, with 64-bit counters
+//
+void nl_base64_stream_enc_ex_start(nl_base64_stream_enc_ex_state_t *state, nl_base64_stream_enc_putchar_t out_putchar, void *context)
+{
+    state->num_encoded = 0;
+    state->num_written = 0;
+    state->putchar     = out_putchar;
+    state->write       = NULL;
+    state->buffer      = NULL;
+    state->buffer_size = 0;
+    state->buffered    = 0;
+    state->line_length = 0;
+    state->column      = 0;
+    state->terminator  = NULL;
+    state->terminator_length = 0;
+    state->url_safe    = false;
+    state->context     = context;
+}
+
+// Start encoding into a caller-supplied staging buffer of at least 4
+// characters, which is passed to out_write each time it fills and once
+// more, if not empty, on finish.
+//
+void nl_base64_stream_enc_ex_start_buffered(nl_base64_stream_enc_ex_state_t *state, char *buffer, size_t buffer_size, nl_base64_stream_enc_write_t out_write, void *context)
+{
+    assert(buffer_size >= 4);
+
+    state->num_encoded = 0;
+    state->num_written = 0;
+    state->putchar     = NULL;
+    state->write       = out_write;
+    state->buffer      = buffer;
+    state->buffer_size = buffer_size;
+    state->buffered    = 0;
+    state->line_length = 0;
+    state->column      = 0;
+    state->terminator  = NULL;
+    state->terminator_length = 0;
+    state->url_safe    = false;
+    state->context     = context;
+}
+
+// Encode in the URL-safe alphabet if NLBASE64_FLAG_URL_SAFE is set.
+// Padding is chosen on finish. Must be called before any input is
+// encoded.
+//
+void nl_base64_stream_enc_ex_set_flags(nl_base64_stream_enc_ex_state_t *state, uint8_t flags)
+{
+    state->url_safe = (flags & NLBASE64_FLAG_URL_SAFE) != 0;
+}
+
+// Wrap the output into lines of line_length characters, each ended with
+// the null-terminated terminator, as is the last line on finish. Must be
+// called before any input is encoded.
+//
+void nl_base64_stream_enc_ex_set_lines(nl_base64_stream_enc_ex_state_t *state, size_t line_length, const char *terminator)
+{
+    state->line_length       = line_length;
+    state->column            = 0;
+    state->terminator        = terminator;
+    state->terminator_length = (terminator != NULL) ? strlen(terminator) : 0;
+}
+
+static void nl_base64_stream_enc_ex_flush(nl_base64_stream_enc_ex_state_t *state)
+{
+    if (state->buffered > 0)
+    {
+        state->write(state->buffer, state->buffered, state->context);
+        state->buffered = 0;
+    }
+}
+
+static void nl_base64_stream_enc_ex_output(const char *chars, size_t len,
+                                           nl_base64_stream_enc_ex_state_t *state)
+{
+    size_t i;
+
+    state->num_written += len;
+
+    if (state->buffer == NULL)
+    {
+        for (i = 0; i < len; i++)
+            state->putchar(chars[i], state->context);
+    }
+    else
+    {
+        while (len > 0)
+        {
+            if (state->buffered == state->buffer_size)
+                nl_base64_stream_enc_ex_flush(state);
+
+            i = state->buffer_size - state->buffered;
+
+            if (i > len)
+                i = len;
+
+            memcpy(state->buffer + state->buffered, chars, i);
+            state->buffered += i;
+            chars += i;
+            len -= i;
+        }
+    }
+}
+
+// Output encoded characters, ending each line with the terminator if
+// wrapping has been set.
+//
+static void nl_base64_stream_enc_ex_wrap(const char *chars, size_t len,
+                                         nl_base64_stream_enc_ex_state_t *state)
+{
+    size_t run;
+
+    if (state->line_length == 0)
+    {
+        nl_base64_stream_enc_ex_output(chars, len, state);
+        return;
+    }
+
+    while (len > 0)
+    {
+        run = state->line_length - state->column;
+
+        if (run > len)
+            run = len;
+
+        nl_base64_stream_enc_ex_output(chars, run, state);
+        state->column += run;
+        chars += run;
+        len -= run;
+
+        if (state->column == state->line_length)
+        {
+            nl_base64_stream_enc_ex_output(state->terminator, state->terminator_length, state);
+            state->column = 0;
+        }
+    }
+}
+
+static void nl_base64_stream_enc_ex_put(char ch, nl_base64_stream_enc_ex_state_t *state)
+{
+    nl_base64_stream_enc_ex_wrap(&ch, 1, state);
+}
+
+uint64_t nl_base64_stream_enc_ex_more(const uint8_t *in, size_t inLen,
+                                      nl_base64_stream_enc_ex_state_t *state)
+{
+    const uint64_t was_written = state->num_written;
+
+    // Complete any group left partially encoded by the previous call.
+
+    while (inLen > 0 && state->num_encoded != 0)
+    {
+        switch (state->num_encoded)
+        {
+        case 1:
+            state->encoded[1] |= *in >> 4;
+            state->encoded[2] =  (*in << 2) & 0x3F;
+            state->num_encoded++;
+            break;
+        case 2:
+            state->encoded[2] |= *in >> 6;
+            nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[0], state->url_safe), state);
+            nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[1], state->url_safe), state);
+            nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[2], state->url_safe), state);
+            nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(*in & 0x3F, state->url_safe), state);
+            state->num_encoded = 0;
+            break;
+        default:
+            assert(state->num_encoded <= 2); // Not possible
+            break;
+        }
+        in++;
+        inLen--;
+    }
+
+    // Run whole groups through the block encoder, directly into the
+    // staging buffer if there is one and the output is not wrapped, or a
+    // chunk at a time otherwise.
+
+    while (inLen >= 3)
+    {
+        char chunk[NLBASE64_STREAM_CHUNK_SIZE];
+        char *dest;
+        size_t space;
+        size_t consumed;
+        size_t produced;
+
+        if (state->buffer != NULL && state->line_length == 0)
+        {
+            if (state->buffer_size - state->buffered < 4)
+                nl_base64_stream_enc_ex_flush(state);
+
+            dest  = state->buffer + state->buffered;
+            space = state->buffer_size - state->buffered;
+        }
+        else
+        {
+            dest  = chunk;
+            space = sizeof (chunk);
+        }
+
+        consumed = (inLen / 3 < space / 4) ? (inLen / 3) * 3 : (space / 4) * 3;
+        produced = nl_base64_encode_alphabet(in, consumed, dest, state->url_safe, true);
+
+        if (dest != chunk)
+        {
+            state->buffered += produced;
+            state->num_written += produced;
+        }
+        else
+        {
+            nl_base64_stream_enc_ex_wrap(chunk, produced, state);
+        }
+
+        in += consumed;
+        inLen -= consumed;
+    }
+
+    // Save any remaining bytes for the next call.
+
+    if (inLen > 0)
+    {
+        state->encoded[0] = *in >> 2;
+        state->encoded[1] = (*in << 4) & 0x3F;
+        state->num_encoded = 1;
         in++;
         inLen--;
     }
 
+    if (inLen > 0)
+    {
+        state->encoded[1] |= *in >> 4;
+        state->encoded[2] =  (*in << 2) & 0x3F;
+        state->num_encoded = 2;
+    }
+
     return (state->num_written - was_written);
 }
 
-uint16_t nl_base64_stream_enc_finish(bool pad, nl_base64_stream_enc_state_t *state)
+uint64_t nl_base64_stream_enc_ex_finish(bool pad, nl_base64_stream_enc_ex_state_t *state)
 {
     switch (state->num_encoded)
     {
@@ -222,28 +1614,342 @@ uint16_t nl_base64_stream_enc_finish(bool pad, nl_base64_stream_enc_state_t *sta
     default:
         break;
     case 1:
-        state->putchar(nl_base64_val_to_char(state->encoded[0]), state->context);
-        state->putchar(nl_base64_val_to_char(state->encoded[1]), state->context);
-        state->num_written += 2;
+        nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[0], state->url_safe), state);
+        nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[1], state->url_safe), state);
         if (pad)
         {
-            state->putchar('=', state->context);
-            state->putchar('=', state->context);
-            state->num_written += 2;
+            nl_base64_stream_enc_ex_put('=', state);
+            nl_base64_stream_enc_ex_put('=', state);
         }
         break;
     case 2:
-        state->putchar(nl_base64_val_to_char(state->encoded[0]), state->context);
-        state->putchar(nl_base64_val_to_char(state->encoded[1]), state->context);
-        state->putchar(nl_base64_val_to_char(state->encoded[2]), state->context);
-        state->num_written += 3;
+        nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[0], state->url_safe), state);
+        nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[1], state->url_safe), state);
+        nl_base64_stream_enc_ex_put(nl_base64_alphabet_char(state->encoded[2], state->url_safe), state);
         if (pad)
         {
-            state->putchar('=', state->context);
-            state->num_written += 1;
+            nl_base64_stream_enc_ex_put('=', state);
         }
         break;
     }
 
+    state->num_encoded = 0;
+
+    if (state->column != 0)
+    {
+        nl_base64_stream_enc_ex_output(state->terminator, state->terminator_length, state);
+        state->column = 0;
+    }
+
+    if (state->buffer != NULL)
+        nl_base64_stream_enc_ex_flush(state);
+
     return state->num_written;
 }
+
+//
+// Decode Base64 in O(1) space
+//
+void nl_base64_stream_dec_start(nl_base64_stream_dec_state_t *state, nl_base64_stream_dec_write_t out_write, void *context)
+{
+    state->last        = 0;
+    state->num_decoded = 0;
+    state->done        = false;
+    state->error       = false;
+    state->skip_whitespace = false;
+    state->url_safe    = false;
+    state->line_length = 0;
+    state->column      = 0;
+    state->num_written = 0;
+    state->crc_update  = NULL;
+    state->crc         = 0;
+    state->write       = out_write;
+    state->context     = context;
+}
+
+// Accept the URL-safe alphabet as well as the standard one if
+// NLBASE64_FLAG_URL_SAFE is set. Must be called before any input is
+// decoded.
+//
+void nl_base64_stream_dec_set_flags(nl_base64_stream_dec_state_t *state, uint8_t flags)
+{
+    state->url_safe = (flags & NLBASE64_FLAG_URL_SAFE) != 0;
+}
+
+// Fold every decoded byte into state->crc, starting from crc, with
+// crc_update, such as nl_crc32 or nl_crc32c. Must be called before any
+// input is decoded.
+//
+void nl_base64_stream_dec_set_crc(nl_base64_stream_dec_state_t *state, nl_base64_crc_update_t crc_update, uint32_t crc)
+{
+    state->crc_update = crc_update;
+    state->crc        = crc;
+}
+
+// As nl_base64_stream_dec_start, but skip whitespace and line breaks, as
+// found in PEM and MIME bodies.
+//
+void nl_base64_stream_dec_start_ws(nl_base64_stream_dec_state_t *state, nl_base64_stream_dec_write_t out_write, void *context)
+{
+    nl_base64_stream_dec_start(state, out_write, context);
+
+    state->skip_whitespace = true;
+}
+
+static inline bool nl_base64_is_whitespace(char ch)
+{
+    return (ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' || ch == '\v' || ch == '\f');
+}
+
+// Decode whole lines of the length seen first in the input, each followed
+// by LF or CR LF, for as long as they are free of whitespace and padding.
+// Each such line is handed to the block decoder without scanning it for
+// whitespace, and its terminator is checked in place.
+//
+// Returns the number of characters consumed, including line terminators.
+//
+static size_t nl_base64_stream_dec_lines(const char *in, size_t inLen, uint8_t **out,
+                                         nl_base64_stream_dec_state_t *state)
+{
+    const char * const inStart = in;
+    const size_t line_length = state->line_length;
+
+    while (inLen > line_length)
+    {
+        size_t terminator;
+
+        if (in[line_length] == '\n')
+            terminator = 1;
+        else if (in[line_length] == '\r' && inLen > line_length + 1 && in[line_length + 1] == '\n')
+            terminator = 2;
+        else
+            break;
+
+        // A line holding anything but whole groups, such as whitespace or
+        // padding, is left for the caller to decode character by character
+        // from its start, overwriting whatever was decoded here.
+
+        if (nl_base64_decode_alphabet(in, line_length, *out, state->url_safe) != line_length / 4 * 3)
+            break;
+
+        in += line_length + terminator;
+        inLen -= line_length + terminator;
+        *out += line_length / 4 * 3;
+    }
+
+    return in - inStart;
+}
+
+// Decode a fragment into out, which must have room for
+// (inLen * 3 + 3) / 4 bytes.
+//
+// Returns the number of bytes written, or SIZE_MAX on error.
+//
+static size_t nl_base64_stream_dec_fragment(const char *in, size_t inLen, uint8_t *out,
+                                            nl_base64_stream_dec_state_t *state)
+{
+    uint8_t *outStart = out;
+
+    while (inLen > 0)
+    {
+        uint8_t val;
+
+        // On a group boundary, hand as many whole groups as possible to
+        // the block decoder.
+
+        if (state->num_decoded == 0)
+        {
+            size_t consumed;
+
+            if (state->line_length != 0 && state->column == 0)
+            {
+                consumed = nl_base64_stream_dec_lines(in, inLen, &out, state);
+
+                in += consumed;
+                inLen -= consumed;
+            }
+
+            consumed = nl_base64_decode_groups(in, inLen, out, state->url_safe);
+
+            in += consumed;
+            inLen -= consumed;
+            out += consumed / 4 * 3;
+            state->column += consumed;
+
+            if (inLen == 0)
+                break;
+        }
+
+        val = nl_base64_alphabet_val(*in, state->url_safe);
+
+        if (val == UINT8_MAX)
+        {
+            if (state->skip_whitespace && nl_base64_is_whitespace(*in))
+            {
+                // The first line that ends on a group boundary sets the
+                // line length for the fast path.
+
+                if (*in == '\n')
+                {
+                    if (state->line_length == 0 && state->column % 4 == 0)
+                        state->line_length = state->column;
+
+                    state->column = 0;
+                }
+
+                in++;
+                inLen--;
+                continue;
+            }
+
+            // As with the block decoder, padding may only appear in the
+            // last two positions of a group and ends the input.
+
+            if (*in == '=' && state->num_decoded >= 2)
+            {
+                state->done = true;
+                break;
+            }
+
+            state->error = true;
+            return SIZE_MAX;
+        }
+
+        switch (state->num_decoded)
+        {
+        case 0:
+        default:
+            break;
+        case 1:
+            *out++ = (state->last << 2) | (val >> 4);
+            break;
+        case 2:
+            *out++ = (state->last << 4) | (val >> 2);
+            break;
+        case 3:
+            *out++ = (state->last << 6) | val;
+            break;
+        }
+
+        state->last = val;
+        state->num_decoded = (state->num_decoded + 1) & 3;
+        state->column++;
+        in++;
+        inLen--;
+    }
+
+    return out - outStart;
+}
+
+// Decode the next fragment of a base64 string. Fragments may split the
+// string at any point, including within a 4-character group.
+//
+// If out is non-NULL, the decoded bytes are written there, and it must
+// have room for (inLen * 3 + 3) / 4 bytes. Otherwise, they are passed to
+// the write function given to nl_base64_stream_dec_start, in one or more
+// blocks.
+//
+// Returns the number of bytes decoded from this fragment, or SIZE_MAX on
+// error. Any input after '=' padding is ignored.
+//
+size_t nl_base64_stream_dec_more(const char *in, size_t inLen, uint8_t *out,
+                                 nl_base64_stream_dec_state_t *state)
+{
+    size_t produced = 0;
+
+    if (state->error)
+        return SIZE_MAX;
+
+    if (out != NULL)
+    {
+        // With a CRC, decode a chunk at a time and fold each into the CRC
+        // while it is still in cache.
+
+        const size_t chunk = (state->crc_update != NULL) ? NLBASE64_CRC_CHUNK_SIZE : SIZE_MAX;
+
+        while (inLen > 0 && !state->done)
+        {
+            const size_t consumed = (inLen < chunk) ? inLen : chunk;
+            const size_t decoded = nl_base64_stream_dec_fragment(in, consumed, out, state);
+
+            if (decoded == SIZE_MAX)
+            {
+                produced = SIZE_MAX;
+                break;
+            }
+
+            if (state->crc_update != NULL)
+                state->crc = state->crc_update(state->crc, out, decoded);
+
+            produced += decoded;
+            in += consumed;
+            inLen -= consumed;
+            out += decoded;
+        }
+    }
+    else
+    {
+        while (inLen > 0 && !state->done)
+        {
+            // A chunk of N characters decodes to at most N bytes.
+
+            uint8_t chunk[NLBASE64_STREAM_CHUNK_SIZE];
+            const size_t consumed = (inLen < sizeof (chunk)) ? inLen : sizeof (chunk);
+            const size_t decoded = nl_base64_stream_dec_fragment(in, consumed, chunk, state);
+
+            if (decoded == SIZE_MAX)
+            {
+                produced = SIZE_MAX;
+                break;
+            }
+
+            if (state->crc_update != NULL)
+                state->crc = state->crc_update(state->crc, chunk, decoded);
+
+            if (decoded > 0)
+                state->write(chunk, decoded, state->context);
+
+            produced += decoded;
+            in += consumed;
+            inLen -= consumed;
+        }
+    }
+
+    if (produced != SIZE_MAX)
+        state->num_written += produced;
+
+    return produced;
+}
+
+// Complete decoding.
+//
+// Returns the total number of bytes decoded, or UINT64_MAX if the string
+// was malformed, including if it ended with a lone character.
+//
+uint64_t nl_base64_stream_dec_finish(nl_base64_stream_dec_state_t *state)
+{
+    if (!state->done && state->num_decoded == 1)
+        state->error = true;
+
+    return state->error ? UINT64_MAX : state->num_written;
+}
+
+// Decode a PEM or MIME body in a single pass, skipping whitespace and
+// line breaks.
+//
+// Returns the number of bytes decoded, or SIZE_MAX on error.
+//
+size_t nl_base64_decode_ws(const char *in, size_t inLen, uint8_t *out)
+{
+    nl_base64_stream_dec_state_t state;
+    size_t result;
+
+    nl_base64_stream_dec_start_ws(&state, NULL, NULL);
+
+    result = nl_base64_stream_dec_more(in, inLen, out, &state);
+
+    if (nl_base64_stream_dec_finish(&state) == UINT64_MAX)
+        result = SIZE_MAX;
+
+    return result;
+}
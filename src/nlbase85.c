@@ -0,0 +1,575 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements block- and streaming-based interfaces for
+ *      Ascii85 (base85) encoding and decoding.
+ *
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <nlbase85.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nlutilities-internal.h"
+
+/*
+ * The number of characters or bytes the streaming encoder and decoder
+ * stage on the stack when they run whole groups through the block
+ * encoder or pass decoded blocks to a write function. As each 'z'
+ * decodes to 4 bytes, the decoder takes a quarter as many characters at
+ * a time. Must be a multiple of 4.
+ */
+#define NLBASE85_STREAM_CHUNK_SIZE 640
+
+// Set in a decode table entry for any character outside the alphabet,
+// including 'z'. It lies above the largest digit, 84, so OR-ing the
+// entries for all five characters of a group preserves it.
+
+#define NLBASE85_INVALID 0x80
+
+// The digit a final partial group is padded with, the largest, so that
+// the bytes it decodes to are those the encoder truncated.
+
+#define NLBASE85_PAD_DIGIT 84
+
+#define NLBASE85_VAL(c) \
+    ((c) >= '!' && (c) <= 'u' ? (c) - '!' : NLBASE85_INVALID)
+
+static const uint8_t nl_base85_dec_table[256] = {
+    NL_TABLE256(NLBASE85_VAL)
+};
+
+// Combine the first four digits of a group, which fit in 32 bits, with
+// the last, failing if the group overflows 32 bits. As 0xFFFFFFFF is
+// exactly 85 * 0x03030303, this needs no 64-bit arithmetic.
+//
+static inline bool nl_base85_combine(uint32_t high, uint8_t low, uint32_t *value)
+{
+    if (high > 0x03030303 || (high == 0x03030303 && low > 0))
+        return false;
+
+    *value = high * 85 + low;
+
+    return true;
+}
+
+static inline void nl_base85_store32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)(value >> 0);
+}
+
+// Return the length of the string that encoding inLen bytes produces,
+// not including any null terminator. This is exact unless
+// NLBASE85_FLAG_ZERO_GROUPS is used, in which case it is an upper bound.
+//
+size_t nl_base85_encoded_len(size_t inLen)
+{
+    const size_t remainder = inLen % 4;
+
+    return (inLen / 4) * 5 + ((remainder != 0) ? remainder + 1 : 0);
+}
+
+// Return the exact number of bytes that decoding a well-formed Ascii85
+// string of inLen characters produces. For malformed input, the result
+// is an upper bound on the number of bytes that nl_base85_decode writes
+// before it reports an error.
+//
+size_t nl_base85_decoded_len(const char *in, size_t inLen)
+{
+    size_t zeros = 0;
+    size_t remainder;
+    size_t i;
+
+    for (i = 0; i < inLen; i++)
+        zeros += (in[i] == 'z');
+
+    inLen -= zeros;
+    remainder = inLen % 5;
+
+    return zeros * 4 + (inLen / 5) * 4 + ((remainder != 0) ? remainder - 1 : 0);
+}
+
+// Encode the five digits of one group, most significant first.
+//
+static inline void nl_base85_encode_value(uint32_t value, char *out)
+{
+    out[4] = (char)('!' + value % 85);
+    value /= 85;
+    out[3] = (char)('!' + value % 85);
+    value /= 85;
+    out[2] = (char)('!' + value % 85);
+    value /= 85;
+    out[1] = (char)('!' + value % 85);
+    value /= 85;
+    out[0] = (char)('!' + value);
+}
+
+// Encode as many whole 4-byte groups as are available in the input,
+// writing zero groups as 'z' if zeros is set.
+//
+// Returns the number of characters written; the number of input bytes
+// consumed is always inLen rounded down to a multiple of 4.
+//
+static size_t nl_base85_encode_groups(const uint8_t *in, size_t inLen, char *out, bool zeros)
+{
+    char *outStart = out;
+
+    while (inLen >= 4)
+    {
+        const uint32_t value = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) |
+                               ((uint32_t)in[2] << 8) | in[3];
+
+        if (value == 0 && zeros)
+        {
+            *out++ = 'z';
+        }
+        else
+        {
+            nl_base85_encode_value(value, out);
+            out += 5;
+        }
+
+        in += 4;
+        inLen -= 4;
+    }
+
+    return out - outStart;
+}
+
+// Encode a final group of fewer than 4 bytes, as if padded with zeros,
+// keeping one character more than the number of bytes.
+//
+// Returns the number of characters written.
+//
+static size_t nl_base85_encode_partial(const uint8_t *in, size_t inLen, char *out)
+{
+    uint8_t group[4] = { 0, 0, 0, 0 };
+    char chars[5];
+
+    if (inLen == 0)
+        return 0;
+
+    memcpy(group, in, inLen);
+    nl_base85_encode_value(((uint32_t)group[0] << 24) | ((uint32_t)group[1] << 16) |
+                           ((uint32_t)group[2] << 8) | group[3], chars);
+    memcpy(out, chars, inLen + 1);
+
+    return inLen + 1;
+}
+
+// Returns the number of characters written, which is not null-terminated.
+//
+size_t nl_base85_encode(const uint8_t *in, size_t inLen, char *out, uint8_t flags)
+{
+    const size_t written = nl_base85_encode_groups(in, inLen, out,
+                                                   (flags & NLBASE85_FLAG_ZERO_GROUPS) != 0);
+    const size_t consumed = inLen / 4 * 4;
+
+    return written + nl_base85_encode_partial(in + consumed, inLen - consumed, out + written);
+}
+
+// Decode as many whole 5-character groups as are available in the input,
+// one table lookup per character, stopping at 'z', at any character
+// outside the alphabet and at any group that overflows 32 bits.
+//
+// Returns the number of characters consumed; the number of bytes written
+// is 4/5 of that.
+//
+static size_t nl_base85_decode_groups(const char *in, size_t inLen, uint8_t *out)
+{
+    const char *inStart = in;
+
+    while (inLen >= 5)
+    {
+        const uint8_t a = nl_base85_dec_table[(uint8_t)in[0]];
+        const uint8_t b = nl_base85_dec_table[(uint8_t)in[1]];
+        const uint8_t c = nl_base85_dec_table[(uint8_t)in[2]];
+        const uint8_t d = nl_base85_dec_table[(uint8_t)in[3]];
+        const uint8_t e = nl_base85_dec_table[(uint8_t)in[4]];
+        uint32_t value;
+
+        if ((a | b | c | d | e) & NLBASE85_INVALID)
+            break;
+
+        if (!nl_base85_combine(((a * 85U + b) * 85U + c) * 85U + d, e, &value))
+            break;
+
+        nl_base85_store32(out, value);
+
+        in += 5;
+        inLen -= 5;
+        out += 4;
+    }
+
+    return in - inStart;
+}
+
+// Decode a final group of 2 to 4 characters, as if padded with 'u'.
+//
+// Returns the number of bytes written, one fewer than the number of
+// characters, or SIZE_MAX on error.
+//
+static size_t nl_base85_decode_partial(uint32_t high, size_t num_digits, uint8_t *out)
+{
+    uint8_t group[4];
+    uint32_t value;
+    size_t i;
+
+    if (num_digits < 2)
+        return SIZE_MAX;
+
+    for (i = num_digits; i < 4; i++)
+        high = high * 85 + NLBASE85_PAD_DIGIT;
+
+    if (!nl_base85_combine(high, NLBASE85_PAD_DIGIT, &value))
+        return SIZE_MAX;
+
+    nl_base85_store32(group, value);
+    memcpy(out, group, num_digits - 1);
+
+    return num_digits - 1;
+}
+
+// Returns the number of bytes decoded, or SIZE_MAX on error.
+//
+size_t nl_base85_decode(const char *in, size_t inLen, uint8_t *out)
+{
+    uint8_t *outStart = out;
+    uint32_t high = 0;
+    size_t decoded;
+    size_t i;
+
+    while (true)
+    {
+        const size_t consumed = nl_base85_decode_groups(in, inLen, out);
+
+        in += consumed;
+        inLen -= consumed;
+        out += consumed / 5 * 4;
+
+        if (inLen == 0 || *in != 'z')
+            break;
+
+        memset(out, 0, 4);
+        out += 4;
+        in++;
+        inLen--;
+    }
+
+    if (inLen == 0)
+        return out - outStart;
+
+    // The block decoder stops at a whole group only if it is malformed;
+    // otherwise, what is left is the final partial group.
+
+    if (inLen >= 5)
+        return SIZE_MAX;
+
+    for (i = 0; i < inLen; i++)
+    {
+        const uint8_t digit = nl_base85_dec_table[(uint8_t)in[i]];
+
+        if (digit & NLBASE85_INVALID)
+            return SIZE_MAX;
+
+        high = high * 85 + digit;
+    }
+
+    decoded = nl_base85_decode_partial(high, inLen, out);
+
+    return (decoded == SIZE_MAX) ? SIZE_MAX : (size_t)(out - outStart) + decoded;
+}
+
+//
+// Encode Ascii85 in O(1) space
+//
+void nl_base85_stream_enc_start(nl_base85_stream_enc_state_t *state, uint8_t flags,
+                                nl_base85_stream_enc_write_t out_write, void *context)
+{
+    state->num_encoded = 0;
+    state->flags       = flags;
+    state->num_written = 0;
+    state->write       = out_write;
+    state->context     = context;
+}
+
+// Returns the number of characters written by this call.
+//
+uint64_t nl_base85_stream_enc_more(const uint8_t *in, size_t inLen,
+                                   nl_base85_stream_enc_state_t *state)
+{
+    const uint64_t was_written = state->num_written;
+    const bool zeros = (state->flags & NLBASE85_FLAG_ZERO_GROUPS) != 0;
+    char chunk[NLBASE85_STREAM_CHUNK_SIZE];
+    size_t len = 0;
+
+    // Complete any group left over from the previous fragment.
+
+    if (state->num_encoded > 0)
+    {
+        while (state->num_encoded < 4 && inLen > 0)
+        {
+            state->encoded[state->num_encoded++] = *in++;
+            inLen--;
+        }
+
+        if (state->num_encoded < 4)
+            return (state->num_written - was_written);
+
+        len = nl_base85_encode_groups(state->encoded, 4, chunk, zeros);
+        state->num_encoded = 0;
+    }
+
+    // Then run whole groups through the block encoder a chunk at a time,
+    // allowing for 5 characters per group.
+
+    while (inLen >= 4)
+    {
+        size_t avail = (sizeof (chunk) - len) / 5 * 4;
+
+        if (avail > inLen)
+            avail = inLen;
+
+        avail &= ~(size_t)3;
+        len += nl_base85_encode_groups(in, avail, chunk + len, zeros);
+        in += avail;
+        inLen -= avail;
+
+        if (len + 5 > sizeof (chunk))
+        {
+            state->write(chunk, len, state->context);
+            state->num_written += len;
+            len = 0;
+        }
+    }
+
+    if (len > 0)
+    {
+        state->write(chunk, len, state->context);
+        state->num_written += len;
+    }
+
+    memcpy(state->encoded, in, inLen);
+    state->num_encoded = (uint8_t)inLen;
+
+    return (state->num_written - was_written);
+}
+
+// Complete encoding.
+//
+// Returns the total number of characters written.
+//
+uint64_t nl_base85_stream_enc_finish(nl_base85_stream_enc_state_t *state)
+{
+    char group[5];
+    const size_t len = nl_base85_encode_partial(state->encoded, state->num_encoded, group);
+
+    if (len > 0)
+    {
+        state->write(group, len, state->context);
+        state->num_written += len;
+    }
+
+    state->num_encoded = 0;
+
+    return state->num_written;
+}
+
+//
+// Decode Ascii85 in O(1) space
+//
+void nl_base85_stream_dec_start(nl_base85_stream_dec_state_t *state,
+                                nl_base85_stream_dec_write_t out_write, void *context)
+{
+    state->value       = 0;
+    state->num_decoded = 0;
+    state->error       = false;
+    state->num_written = 0;
+    state->write       = out_write;
+    state->context     = context;
+}
+
+// Decode one fragment into out, carrying the digits of a group split
+// across fragments in state. Whole groups at a group boundary go through
+// the block decoder; the rest are accumulated a digit at a time.
+//
+// Returns the number of bytes written to out, or SIZE_MAX on error.
+//
+static size_t nl_base85_stream_dec_fragment(const char *in, size_t inLen, uint8_t *out,
+                                            nl_base85_stream_dec_state_t *state)
+{
+    uint8_t *outStart = out;
+
+    while (inLen > 0)
+    {
+        uint8_t digit;
+        char ch;
+
+        if (state->num_decoded == 0)
+        {
+            const size_t consumed = nl_base85_decode_groups(in, inLen, out);
+
+            in += consumed;
+            inLen -= consumed;
+            out += consumed / 5 * 4;
+
+            if (inLen == 0)
+                break;
+        }
+
+        ch = *in++;
+        inLen--;
+
+        if (ch == 'z' && state->num_decoded == 0)
+        {
+            memset(out, 0, 4);
+            out += 4;
+            continue;
+        }
+
+        digit = nl_base85_dec_table[(uint8_t)ch];
+
+        if (digit & NLBASE85_INVALID)
+        {
+            state->error = true;
+            break;
+        }
+
+        if (state->num_decoded < 4)
+        {
+            state->value = state->value * 85 + digit;
+            state->num_decoded++;
+        }
+        else
+        {
+            uint32_t value;
+
+            if (!nl_base85_combine(state->value, digit, &value))
+            {
+                state->error = true;
+                break;
+            }
+
+            nl_base85_store32(out, value);
+            out += 4;
+
+            state->value = 0;
+            state->num_decoded = 0;
+        }
+    }
+
+    return state->error ? SIZE_MAX : (size_t)(out - outStart);
+}
+
+// Decode a fragment of an Ascii85 string. If out is not NULL, the decoded
+// bytes are written there, and it must have room for
+// nl_base85_decoded_len(in, inLen) + 4 bytes; otherwise they are passed
+// to the write function a block at a time.
+//
+// Returns the number of bytes decoded from this fragment, or SIZE_MAX on
+// error.
+//
+size_t nl_base85_stream_dec_more(const char *in, size_t inLen, uint8_t *out,
+                                 nl_base85_stream_dec_state_t *state)
+{
+    size_t produced = 0;
+
+    if (state->error)
+        return SIZE_MAX;
+
+    if (out != NULL)
+    {
+        produced = nl_base85_stream_dec_fragment(in, inLen, out, state);
+    }
+    else
+    {
+        while (inLen > 0)
+        {
+            // A chunk of N characters decodes to at most 4N bytes, all
+            // 'z', or N bytes otherwise.
+
+            uint8_t chunk[NLBASE85_STREAM_CHUNK_SIZE];
+            const size_t consumed = (inLen < sizeof (chunk) / 4) ? inLen : sizeof (chunk) / 4;
+            const size_t decoded = nl_base85_stream_dec_fragment(in, consumed, chunk, state);
+
+            if (decoded == SIZE_MAX)
+            {
+                produced = SIZE_MAX;
+                break;
+            }
+
+            if (decoded > 0)
+                state->write(chunk, decoded, state->context);
+
+            produced += decoded;
+            in += consumed;
+            inLen -= consumed;
+        }
+    }
+
+    if (produced != SIZE_MAX)
+        state->num_written += produced;
+
+    return produced;
+}
+
+// Complete decoding, writing the up to 3 bytes of a final partial group
+// to out or, if out is NULL, to the write function.
+//
+// Returns the total number of bytes decoded, or UINT64_MAX if the string
+// was malformed, including if it ended with a lone character.
+//
+uint64_t nl_base85_stream_dec_finish(uint8_t *out, nl_base85_stream_dec_state_t *state)
+{
+    uint8_t group[3];
+    size_t decoded;
+
+    if (state->error)
+        return UINT64_MAX;
+
+    if (state->num_decoded == 0)
+        return state->num_written;
+
+    decoded = nl_base85_decode_partial(state->value, state->num_decoded, (out != NULL) ? out : group);
+
+    if (decoded == SIZE_MAX)
+    {
+        state->error = true;
+        return UINT64_MAX;
+    }
+
+    if (out == NULL)
+        state->write(group, decoded, state->context);
+
+    state->num_written += decoded;
+    state->value = 0;
+    state->num_decoded = 0;
+
+    return state->num_written;
+}
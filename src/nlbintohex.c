@@ -26,6 +26,81 @@
 
 #include <nlutilities.h>
 
+#include <string.h>
+
+#include "nlutilities-internal.h"
+
+/**
+ *  @def NLBINTOHEX_USE_SSE2
+ *
+ *  @brief
+ *    The SSE2 build feature enables a vectorized converter that turns
+ *    16 bytes into 32 hexadecimal digits per iteration. It is enabled
+ *    by default whenever the compiler targets SSE2.
+ */
+#ifndef NLBINTOHEX_USE_SSE2
+#if defined(__SSE2__)
+#define NLBINTOHEX_USE_SSE2 1
+#else
+#define NLBINTOHEX_USE_SSE2 0
+#endif
+#endif /* NLBINTOHEX_USE_SSE2 */
+
+/**
+ *  @def NLBINTOHEX_USE_SSSE3
+ *
+ *  @brief
+ *    The SSSE3 build feature maps nibbles to digits with a single
+ *    byte shuffle and inserts separators with shuffles as well,
+ *    rather than a digit at a time. It is enabled by default whenever
+ *    the compiler targets SSSE3 (for example, with -mssse3).
+ */
+#ifndef NLBINTOHEX_USE_SSSE3
+#if defined(__SSSE3__)
+#define NLBINTOHEX_USE_SSSE3 1
+#else
+#define NLBINTOHEX_USE_SSSE3 0
+#endif
+#endif /* NLBINTOHEX_USE_SSSE3 */
+
+/**
+ *  @def NLBINTOHEX_USE_AVX2
+ *
+ *  @brief
+ *    The AVX2 build feature enables a vectorized converter that turns
+ *    32 bytes into 64 hexadecimal digits per iteration when no
+ *    separator is requested. It is enabled by default whenever the
+ *    compiler targets AVX2 (for example, with -mavx2 or
+ *    -march=native).
+ */
+#ifndef NLBINTOHEX_USE_AVX2
+#if defined(__AVX2__)
+#define NLBINTOHEX_USE_AVX2 1
+#else
+#define NLBINTOHEX_USE_AVX2 0
+#endif
+#endif /* NLBINTOHEX_USE_AVX2 */
+
+#if NLBINTOHEX_USE_AVX2
+#include <immintrin.h>
+#elif NLBINTOHEX_USE_SSSE3
+#include <tmmintrin.h>
+#elif NLBINTOHEX_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define NLBINTOHEX_DIGIT(n, a)   ((char)((n) < 10 ? '0' + (n) : (a) + (n) - 10))
+#define NLBINTOHEX_UPPER(b)      { NLBINTOHEX_DIGIT((b) >> 4, 'A'), NLBINTOHEX_DIGIT((b) & 0xf, 'A') }
+#define NLBINTOHEX_LOWER(b)      { NLBINTOHEX_DIGIT((b) >> 4, 'a'), NLBINTOHEX_DIGIT((b) & 0xf, 'a') }
+
+// Indexed by whether NLBINTOHEX_FLAG_LOWER_CASE is set, then by the
+// byte.
+
+const char nl_bintohex_pairs[2][256][2] = {
+    { NL_TABLE256(NLBINTOHEX_UPPER) },
+    { NL_TABLE256(NLBINTOHEX_LOWER) }
+};
+
 static char nibble_to_hex(uint8_t x)
 {
     x &= 0xf;
@@ -33,12 +108,183 @@ static char nibble_to_hex(uint8_t x)
     return (x > 9) ? (x - 10 + 'A') : (x + '0');
 }
 
+#if NLBINTOHEX_USE_SSE2 || NLBINTOHEX_USE_SSSE3
+// Map each nibble, 0 through 15, in the low half of its byte to its
+// upper-case hexadecimal digit.
+
+static inline __m128i nl_bintohex_digits(__m128i nibbles)
+{
+#if NLBINTOHEX_USE_SSSE3
+    return _mm_shuffle_epi8(_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                          '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'), nibbles);
+#else
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+                                          _mm_set1_epi8('A' - '0' - 10));
+
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+#endif
+}
+
+// Convert 16 bytes to 32 digits, in order: those of the first 8 bytes
+// in *first and those of the last 8 in *second.
+
+static inline void nl_bintohex_16(const uint8_t *src, __m128i *first, __m128i *second)
+{
+    const __m128i mask  = _mm_set1_epi8(0x0f);
+    const __m128i bytes = _mm_loadu_si128((const __m128i *)src);
+    const __m128i high  = nl_bintohex_digits(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+    const __m128i low   = nl_bintohex_digits(_mm_and_si128(bytes, mask));
+
+    *first  = _mm_unpacklo_epi8(high, low);
+    *second = _mm_unpackhi_epi8(high, low);
+}
+
+// Convert as many whole 16-byte blocks as are available in the input,
+// without separators.
+//
+// Returns the number of bytes consumed; the number of digits written is
+// twice that.
+//
+static size_t nl_bintohex_sse2(char *dest, const uint8_t *src, size_t srclen)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= srclen; i += 16)
+    {
+        __m128i first, second;
+
+        nl_bintohex_16(&src[i], &first, &second);
+
+        _mm_storeu_si128((__m128i *)&dest[i * 2], first);
+        _mm_storeu_si128((__m128i *)&dest[i * 2 + 16], second);
+    }
+
+    return i;
+}
+
+// Convert whole 16-byte blocks with a separator after every 2 bytes,
+// stopping short of the last byte so that each block is followed by
+// more output and its final separator is always wanted. Each block
+// becomes 40 characters: 8 groups of 4 digits, each followed by sep.
+//
+// Returns the number of bytes consumed; the number of characters
+// written is 5/2 of that.
+//
+static size_t nl_bintohex_sep_sse2(char *dest, const uint8_t *src, size_t srclen, char sep)
+{
+    size_t i;
+
+    for (i = 0; i + 16 < srclen; i += 16)
+    {
+        char *d = &dest[i / 2 * 5];
+        __m128i first, second;
+
+#if NLBINTOHEX_USE_SSSE3
+        // Spread the digits out with shuffles, leaving zeros where the
+        // separators go, then fill those in. The middle 16 characters
+        // straddle both halves, so they are shuffled from the last 3
+        // digits of the first half and the first 13 of the second.
+
+        const __m128i seps    = _mm_set1_epi8(sep);
+        const __m128i spread0 = _mm_setr_epi8(0, 1, 2, 3, -1, 4, 5, 6, 7, -1, 8, 9, 10, 11, -1, 12);
+        const __m128i spread1 = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, 6, -1, 7, 8, 9, 10, -1, 11, 12);
+        const __m128i spread2 = _mm_setr_epi8(10, 11, -1, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i gaps0   = _mm_setr_epi8(0, 0, 0, 0, -1, 0, 0, 0, 0, -1, 0, 0, 0, 0, -1, 0);
+        const __m128i gaps1   = _mm_setr_epi8(0, 0, 0, -1, 0, 0, 0, 0, -1, 0, 0, 0, 0, -1, 0, 0);
+        const __m128i gaps2   = _mm_setr_epi8(0, 0, -1, 0, 0, 0, 0, -1, 0, 0, 0, 0, 0, 0, 0, 0);
+
+        nl_bintohex_16(&src[i], &first, &second);
+
+        _mm_storeu_si128((__m128i *)&d[0],
+                         _mm_or_si128(_mm_shuffle_epi8(first, spread0), _mm_and_si128(seps, gaps0)));
+        _mm_storeu_si128((__m128i *)&d[16],
+                         _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(second, first, 13), spread1),
+                                      _mm_and_si128(seps, gaps1)));
+        _mm_storel_epi64((__m128i *)&d[32],
+                         _mm_or_si128(_mm_shuffle_epi8(second, spread2), _mm_and_si128(seps, gaps2)));
+#else
+        // Without a byte shuffle, convert to a staging buffer and copy
+        // the groups out 4 digits at a time.
+
+        char digits[32];
+        size_t j;
+
+        nl_bintohex_16(&src[i], &first, &second);
+
+        _mm_storeu_si128((__m128i *)&digits[0], first);
+        _mm_storeu_si128((__m128i *)&digits[16], second);
+
+        for (j = 0; j < 8; j++)
+        {
+            memcpy(&d[j * 5], &digits[j * 4], 4);
+            d[j * 5 + 4] = sep;
+        }
+#endif
+    }
+
+    return i;
+}
+#endif /* NLBINTOHEX_USE_SSE2 || NLBINTOHEX_USE_SSSE3 */
+
+#if NLBINTOHEX_USE_AVX2
+// Convert as many whole 32-byte blocks as are available in the input,
+// without separators. Byte unpacking works within each 128-bit lane, so
+// the lanes are swapped back into order before storing.
+//
+// Returns the number of bytes consumed; the number of digits written is
+// twice that.
+//
+static size_t nl_bintohex_avx2(char *dest, const uint8_t *src, size_t srclen)
+{
+    const __m256i mask   = _mm256_set1_epi8(0x0f);
+    const __m256i digits = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                            '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+                                            '0', '1', '2', '3', '4', '5', '6', '7',
+                                            '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+    size_t i;
+
+    for (i = 0; i + 32 <= srclen; i += 32)
+    {
+        const __m256i bytes = _mm256_loadu_si256((const __m256i *)&src[i]);
+        const __m256i high  = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), mask));
+        const __m256i low   = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, mask));
+        const __m256i first = _mm256_unpacklo_epi8(high, low);
+        const __m256i last  = _mm256_unpackhi_epi8(high, low);
+
+        _mm256_storeu_si256((__m256i *)&dest[i * 2], _mm256_permute2x128_si256(first, last, 0x20));
+        _mm256_storeu_si256((__m256i *)&dest[i * 2 + 32], _mm256_permute2x128_si256(first, last, 0x31));
+    }
+
+    return i;
+}
+#endif /* NLBINTOHEX_USE_AVX2 */
+
 char *nl_bintohexstr(char *dest, const uint8_t *src, size_t srclen, char sep)
 {
     size_t i = 0;
     char *d = dest;
 
-    for (i = 0; i < srclen; i++)
+    // Convert the bulk of the input a block at a time, leaving the rest
+    // to the scalar loop, which picks up with the same separator
+    // pattern as whole blocks span an even number of bytes.
+
+#if NLBINTOHEX_USE_SSE2 || NLBINTOHEX_USE_SSSE3
+    if (sep)
+    {
+        i = nl_bintohex_sep_sse2(d, src, srclen, sep);
+        d += i / 2 * 5;
+    }
+    else
+    {
+#if NLBINTOHEX_USE_AVX2
+        i = nl_bintohex_avx2(d, src, srclen);
+#endif
+        i += nl_bintohex_sse2(d + i * 2, src + i, srclen - i);
+        d += i * 2;
+    }
+#endif
+
+    for (; i < srclen; i++)
     {
         *d++ = nibble_to_hex(src[i] >> 4);
         *d++ = nibble_to_hex(src[i] & 0xf);
@@ -52,3 +298,79 @@ char *nl_bintohexstr(char *dest, const uint8_t *src, size_t srclen, char sep)
 
     return dest;
 }
+
+size_t nl_bintohexstr_grouped_len(size_t srclen, size_t group, size_t seplen)
+{
+    if (srclen == 0 || group == 0)
+        return srclen * 2;
+
+    return srclen * 2 + (srclen - 1) / group * seplen;
+}
+
+char *nl_bintohexstr_grouped(char *dest, const uint8_t *src, size_t srclen, size_t group, const char *sep, uint8_t flags)
+{
+    const char (*pairs)[2] = nl_bintohex_pairs[(flags & NLBINTOHEX_FLAG_LOWER_CASE) ? 1 : 0];
+    const size_t seplen = (sep != NULL) ? strlen(sep) : 0;
+    const char sepchar = (seplen > 0) ? sep[0] : '\0';
+    char *d = dest;
+    size_t i;
+    size_t j;
+
+    if (seplen == 0)
+        group = 0;
+
+    // Upper case without separators, or with a single character after
+    // every two bytes, is what nl_bintohexstr produces with its
+    // vectorized converters.
+
+    if (!(flags & NLBINTOHEX_FLAG_LOWER_CASE) && (group == 0 || (group == 2 && seplen == 1)))
+        return nl_bintohexstr(dest, src, srclen, (group == 0) ? '\0' : sep[0]);
+
+    if (group == 0 || group > srclen)
+        group = srclen;
+
+    // Every group but the last is followed by a separator. The common
+    // case of one byte per group, as in MAC addresses, gets a loop of
+    // its own, without the group loop around each byte.
+
+    if (group == 1 && seplen == 1)
+    {
+        for (i = 0; i + 1 < srclen; i++)
+        {
+            memcpy(d, pairs[src[i]], 2);
+            d[2] = sepchar;
+            d += 3;
+        }
+    }
+    else
+    {
+        for (i = 0; i + group < srclen; i += group)
+        {
+            for (j = 0; j < group; j++)
+            {
+                memcpy(d, pairs[src[i + j]], 2);
+                d += 2;
+            }
+
+            if (seplen == 1)
+            {
+                *d++ = sepchar;
+            }
+            else
+            {
+                memcpy(d, sep, seplen);
+                d += seplen;
+            }
+        }
+    }
+
+    for (; i < srclen; i++)
+    {
+        memcpy(d, pairs[src[i]], 2);
+        d += 2;
+    }
+
+    *d = '\0';
+
+    return dest;
+}
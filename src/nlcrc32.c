@@ -0,0 +1,317 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements interfaces for computing the CRC-32 of
+ *      IEEE 802.3 and the CRC-32C (Castagnoli) of iSCSI and SCTP.
+ *
+ */
+
+#include <nlcrc32.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nlutilities-internal.h"
+
+/**
+ *  @def NLCRC32_USE_SSE42
+ *
+ *  @brief
+ *    The SSE4.2 build feature computes the CRC-32C with the crc32
+ *    instruction, 8 bytes at a time. It is enabled by default whenever
+ *    the compiler targets SSE4.2. SSE4.2 has no instruction for the
+ *    IEEE polynomial, which always uses the tables. As with the other
+ *    build features, the processor is not probed at run time.
+ */
+#ifndef NLCRC32_USE_SSE42
+#if defined(__SSE4_2__)
+#define NLCRC32_USE_SSE42 1
+#else
+#define NLCRC32_USE_SSE42 0
+#endif
+#endif /* NLCRC32_USE_SSE42 */
+
+/**
+ *  @def NLCRC32_USE_ARM_CRC32
+ *
+ *  @brief
+ *    The ARM CRC32 build feature computes both CRCs with the crc32 and
+ *    crc32c instructions of ARMv8, 8 bytes at a time. It is enabled by
+ *    default whenever the compiler targets the CRC extension (for
+ *    example, with -march=armv8-a+crc).
+ */
+#ifndef NLCRC32_USE_ARM_CRC32
+#if defined(__ARM_FEATURE_CRC32)
+#define NLCRC32_USE_ARM_CRC32 1
+#else
+#define NLCRC32_USE_ARM_CRC32 0
+#endif
+#endif /* NLCRC32_USE_ARM_CRC32 */
+
+#if NLCRC32_USE_ARM_CRC32
+#include <arm_acle.h>
+#elif NLCRC32_USE_SSE42
+#include <nmmintrin.h>
+#endif
+
+/*
+ * Slicing-by-8 tables, 8 KiB per polynomial, for targets without CRC
+ * instructions. Entry [k][n] is the CRC of byte n followed by k zero
+ * bytes, so that 8 bytes can be folded into the CRC with 8 independent
+ * lookups. Only the tables a target actually uses are built.
+ *
+ * The compiler builds them from the polynomial. Each entry is linear in
+ * its byte, the XOR of the entries of the bits set in it, and the entry
+ * of bit b of table k is the polynomial run through 8 * k + 7 - b more
+ * steps of the bitwise CRC. Those 64 entries follow one from the next,
+ * as enumerators so that each is computed only once, in 16-bit halves
+ * to fit in an int.
+ */
+#define NL_CRC32_STEP_LO(p, x) \
+    ((((x##_lo) >> 1) | (((x##_hi) & 1) << 15)) ^ (((x##_lo) & 1) ? (int)((p) & 0xFFFF) : 0))
+#define NL_CRC32_STEP_HI(p, x) \
+    (((x##_hi) >> 1) ^ (((x##_lo) & 1) ? (int)((p) >> 16) : 0))
+
+#define NL_CRC32_STEP(p, n, j, a, k, b) \
+    n##_##k##_##b##_lo = NL_CRC32_STEP_LO(p, n##_##j##_##a), \
+    n##_##k##_##b##_hi = NL_CRC32_STEP_HI(p, n##_##j##_##a)
+
+#define NL_CRC32_STEPS(p, n, k) \
+    NL_CRC32_STEP(p, n, k, 7, k, 6), NL_CRC32_STEP(p, n, k, 6, k, 5), \
+    NL_CRC32_STEP(p, n, k, 5, k, 4), NL_CRC32_STEP(p, n, k, 4, k, 3), \
+    NL_CRC32_STEP(p, n, k, 3, k, 2), NL_CRC32_STEP(p, n, k, 2, k, 1), \
+    NL_CRC32_STEP(p, n, k, 1, k, 0)
+
+#define NL_CRC32_BITS(p, n) \
+    n##_0_7_lo = (int)((p) & 0xFFFF), n##_0_7_hi = (int)((p) >> 16), NL_CRC32_STEPS(p, n, 0), \
+    NL_CRC32_STEP(p, n, 0, 0, 1, 7), NL_CRC32_STEPS(p, n, 1), \
+    NL_CRC32_STEP(p, n, 1, 0, 2, 7), NL_CRC32_STEPS(p, n, 2), \
+    NL_CRC32_STEP(p, n, 2, 0, 3, 7), NL_CRC32_STEPS(p, n, 3), \
+    NL_CRC32_STEP(p, n, 3, 0, 4, 7), NL_CRC32_STEPS(p, n, 4), \
+    NL_CRC32_STEP(p, n, 4, 0, 5, 7), NL_CRC32_STEPS(p, n, 5), \
+    NL_CRC32_STEP(p, n, 5, 0, 6, 7), NL_CRC32_STEPS(p, n, 6), \
+    NL_CRC32_STEP(p, n, 6, 0, 7, 7), NL_CRC32_STEPS(p, n, 7)
+
+#define NL_CRC32_BIT(n, k, b, i) \
+    (((i) & (1 << (b))) ? (((uint32_t)n##_##k##_##b##_hi << 16) | (uint32_t)n##_##k##_##b##_lo) : 0)
+
+#define NL_CRC32_ENTRY(n, k, i) \
+    (NL_CRC32_BIT(n, k, 0, i) ^ NL_CRC32_BIT(n, k, 1, i) ^ NL_CRC32_BIT(n, k, 2, i) ^ NL_CRC32_BIT(n, k, 3, i) ^ \
+     NL_CRC32_BIT(n, k, 4, i) ^ NL_CRC32_BIT(n, k, 5, i) ^ NL_CRC32_BIT(n, k, 6, i) ^ NL_CRC32_BIT(n, k, 7, i))
+
+#if !NLCRC32_USE_ARM_CRC32
+enum { NL_CRC32_BITS(0xEDB88320, nl_crc32) };
+
+#define NL_CRC32_ENTRY0(i) NL_CRC32_ENTRY(nl_crc32, 0, i)
+#define NL_CRC32_ENTRY1(i) NL_CRC32_ENTRY(nl_crc32, 1, i)
+#define NL_CRC32_ENTRY2(i) NL_CRC32_ENTRY(nl_crc32, 2, i)
+#define NL_CRC32_ENTRY3(i) NL_CRC32_ENTRY(nl_crc32, 3, i)
+#define NL_CRC32_ENTRY4(i) NL_CRC32_ENTRY(nl_crc32, 4, i)
+#define NL_CRC32_ENTRY5(i) NL_CRC32_ENTRY(nl_crc32, 5, i)
+#define NL_CRC32_ENTRY6(i) NL_CRC32_ENTRY(nl_crc32, 6, i)
+#define NL_CRC32_ENTRY7(i) NL_CRC32_ENTRY(nl_crc32, 7, i)
+
+static const uint32_t nl_crc32_table[8][256] = {
+    { NL_TABLE256(NL_CRC32_ENTRY0) }, { NL_TABLE256(NL_CRC32_ENTRY1) },
+    { NL_TABLE256(NL_CRC32_ENTRY2) }, { NL_TABLE256(NL_CRC32_ENTRY3) },
+    { NL_TABLE256(NL_CRC32_ENTRY4) }, { NL_TABLE256(NL_CRC32_ENTRY5) },
+    { NL_TABLE256(NL_CRC32_ENTRY6) }, { NL_TABLE256(NL_CRC32_ENTRY7) }
+};
+#endif /* !NLCRC32_USE_ARM_CRC32 */
+
+#if !NLCRC32_USE_ARM_CRC32 && !NLCRC32_USE_SSE42
+enum { NL_CRC32_BITS(0x82F63B78, nl_crc32c) };
+
+#define NL_CRC32C_ENTRY0(i) NL_CRC32_ENTRY(nl_crc32c, 0, i)
+#define NL_CRC32C_ENTRY1(i) NL_CRC32_ENTRY(nl_crc32c, 1, i)
+#define NL_CRC32C_ENTRY2(i) NL_CRC32_ENTRY(nl_crc32c, 2, i)
+#define NL_CRC32C_ENTRY3(i) NL_CRC32_ENTRY(nl_crc32c, 3, i)
+#define NL_CRC32C_ENTRY4(i) NL_CRC32_ENTRY(nl_crc32c, 4, i)
+#define NL_CRC32C_ENTRY5(i) NL_CRC32_ENTRY(nl_crc32c, 5, i)
+#define NL_CRC32C_ENTRY6(i) NL_CRC32_ENTRY(nl_crc32c, 6, i)
+#define NL_CRC32C_ENTRY7(i) NL_CRC32_ENTRY(nl_crc32c, 7, i)
+
+static const uint32_t nl_crc32c_table[8][256] = {
+    { NL_TABLE256(NL_CRC32C_ENTRY0) }, { NL_TABLE256(NL_CRC32C_ENTRY1) },
+    { NL_TABLE256(NL_CRC32C_ENTRY2) }, { NL_TABLE256(NL_CRC32C_ENTRY3) },
+    { NL_TABLE256(NL_CRC32C_ENTRY4) }, { NL_TABLE256(NL_CRC32C_ENTRY5) },
+    { NL_TABLE256(NL_CRC32C_ENTRY6) }, { NL_TABLE256(NL_CRC32C_ENTRY7) }
+};
+#endif /* !NLCRC32_USE_ARM_CRC32 && !NLCRC32_USE_SSE42 */
+
+#if !NLCRC32_USE_ARM_CRC32
+static inline uint32_t nl_crc32_load_le32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Fold inLen bytes into the inverted CRC crc, a byte at a time up to an
+// 8-byte boundary and then 8 bytes at a time.
+//
+static inline uint32_t nl_crc32_slice8(const uint32_t table[8][256], uint32_t crc,
+                                       const uint8_t *in, size_t inLen)
+{
+    while (inLen > 0 && ((uintptr_t)in & 7) != 0)
+    {
+        crc = table[0][(crc ^ *in++) & 0xFF] ^ (crc >> 8);
+        inLen--;
+    }
+
+    while (inLen >= 8)
+    {
+        const uint32_t lo = nl_crc32_load_le32(in) ^ crc;
+        const uint32_t hi = nl_crc32_load_le32(in + 4);
+
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+              table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+              table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+
+        in += 8;
+        inLen -= 8;
+    }
+
+    while (inLen > 0)
+    {
+        crc = table[0][(crc ^ *in++) & 0xFF] ^ (crc >> 8);
+        inLen--;
+    }
+
+    return crc;
+}
+#endif /* !NLCRC32_USE_ARM_CRC32 */
+
+#if NLCRC32_USE_ARM_CRC32
+static inline uint32_t nl_crc32_arm(uint32_t crc, const uint8_t *in, size_t inLen, bool castagnoli)
+{
+    while (inLen > 0 && ((uintptr_t)in & 7) != 0)
+    {
+        crc = castagnoli ? __crc32cb(crc, *in) : __crc32b(crc, *in);
+        in++;
+        inLen--;
+    }
+
+    while (inLen >= 8)
+    {
+        uint64_t value;
+
+        memcpy(&value, in, sizeof (value));
+
+        crc = castagnoli ? __crc32cd(crc, value) : __crc32d(crc, value);
+        in += 8;
+        inLen -= 8;
+    }
+
+    while (inLen > 0)
+    {
+        crc = castagnoli ? __crc32cb(crc, *in) : __crc32b(crc, *in);
+        in++;
+        inLen--;
+    }
+
+    return crc;
+}
+#endif /* NLCRC32_USE_ARM_CRC32 */
+
+#if NLCRC32_USE_SSE42 && !NLCRC32_USE_ARM_CRC32
+static uint32_t nl_crc32c_sse42(uint32_t crc, const uint8_t *in, size_t inLen)
+{
+    while (inLen > 0 && ((uintptr_t)in & 7) != 0)
+    {
+        crc = _mm_crc32_u8(crc, *in++);
+        inLen--;
+    }
+
+#if defined(__x86_64__)
+    {
+        uint64_t crc64 = crc;
+
+        while (inLen >= 8)
+        {
+            uint64_t value;
+
+            memcpy(&value, in, sizeof (value));
+
+            crc64 = _mm_crc32_u64(crc64, value);
+            in += 8;
+            inLen -= 8;
+        }
+
+        crc = (uint32_t)crc64;
+    }
+#endif
+
+    while (inLen >= 4)
+    {
+        uint32_t value;
+
+        memcpy(&value, in, sizeof (value));
+
+        crc = _mm_crc32_u32(crc, value);
+        in += 4;
+        inLen -= 4;
+    }
+
+    while (inLen > 0)
+    {
+        crc = _mm_crc32_u8(crc, *in++);
+        inLen--;
+    }
+
+    return crc;
+}
+#endif /* NLCRC32_USE_SSE42 && !NLCRC32_USE_ARM_CRC32 */
+
+// Compute the CRC-32 of IEEE 802.3, as used by Ethernet, zlib, and PNG:
+// the reflected polynomial 0xEDB88320, with an initial value and final
+// XOR of all ones.
+//
+uint32_t nl_crc32(uint32_t crc, const void *in, size_t inLen)
+{
+    const uint8_t *bytes = (const uint8_t *)in;
+
+#if NLCRC32_USE_ARM_CRC32
+    crc = nl_crc32_arm(~crc, bytes, inLen, false);
+#else
+    crc = nl_crc32_slice8(nl_crc32_table, ~crc, bytes, inLen);
+#endif
+
+    return ~crc;
+}
+
+// Compute the CRC-32C of iSCSI and SCTP: the reflected Castagnoli
+// polynomial 0x82F63B78, with an initial value and final XOR of all ones.
+//
+uint32_t nl_crc32c(uint32_t crc, const void *in, size_t inLen)
+{
+    const uint8_t *bytes = (const uint8_t *)in;
+
+#if NLCRC32_USE_ARM_CRC32
+    crc = nl_crc32_arm(~crc, bytes, inLen, true);
+#elif NLCRC32_USE_SSE42
+    crc = nl_crc32c_sse42(~crc, bytes, inLen);
+#else
+    crc = nl_crc32_slice8(nl_crc32c_table, ~crc, bytes, inLen);
+#endif
+
+    return ~crc;
+}
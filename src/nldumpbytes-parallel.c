@@ -0,0 +1,434 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a parallel, memory-mapped hex dump of very
+ *      large files, such as core files and flash images.
+ *
+ */
+
+#include <nlutilities.h>
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "nlutilities-internal.h"
+
+/**
+ *  @def NLDUMPBYTES_USE_MMAP
+ *
+ *  @brief
+ *    The memory-mapped files build feature enables nl_dump_file_parallel.
+ *    Without it, that function fails with ENOSYS. It is enabled by
+ *    default whenever the target advertises memory-mapped files.
+ */
+#ifndef NLDUMPBYTES_USE_MMAP
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#define NLDUMPBYTES_USE_MMAP 1
+#else
+#define NLDUMPBYTES_USE_MMAP 0
+#endif
+#endif /* NLDUMPBYTES_USE_MMAP */
+
+/**
+ *  @def NLDUMPBYTES_USE_PTHREADS
+ *
+ *  @brief
+ *    The POSIX threads build feature lets nl_dump_file_parallel format
+ *    on threads of its own. Without it, the file is formatted and
+ *    written a slice at a time on the calling thread. It is enabled by
+ *    default whenever the target advertises POSIX threads.
+ */
+#ifndef NLDUMPBYTES_USE_PTHREADS
+#if defined(_POSIX_THREADS) && (_POSIX_THREADS > 0)
+#define NLDUMPBYTES_USE_PTHREADS 1
+#else
+#define NLDUMPBYTES_USE_PTHREADS 0
+#endif
+#endif /* NLDUMPBYTES_USE_PTHREADS */
+
+/*
+ * The largest number of formatting threads. Bounds the per-call
+ * bookkeeping, which lives on the stack.
+ */
+#define NLDUMPBYTES_PARALLEL_MAX_TASKS 64
+
+/*
+ * The number of lines in each slice of the file that a thread formats
+ * in one go, into one of its two output buffers. Memory use is about
+ * 2 * 90 bytes per line per thread, however large the file.
+ */
+#define NLDUMPBYTES_PARALLEL_SLICE_LINES 4096
+
+#define NLDUMPBYTES_PARALLEL_SLICE_BYTES (NLDUMPBYTES_PARALLEL_SLICE_LINES * 16)
+
+/*
+ * The size of each output buffer: a slice, plus the line before it,
+ * which is formatted and dropped when squeezing.
+ */
+#define NLDUMPBYTES_PARALLEL_BUFFER_SIZE ((NLDUMPBYTES_PARALLEL_SLICE_LINES + 1) * NLDUMPBYTES_LINE_MAX)
+
+#if NLDUMPBYTES_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if NLDUMPBYTES_USE_PTHREADS
+#include <pthread.h>
+#endif
+
+#if NLDUMPBYTES_USE_MMAP
+typedef struct {
+    char   *buffer;
+    size_t  len;
+} nl_dump_parallel_output_t;
+
+typedef struct {
+    const uint8_t *          bytes;
+    size_t                   size;
+    uintptr_t                offs;
+    uint8_t                  flags;
+    size_t                   num_slices;
+    nl_dump_bytes_write_t    out_write;
+    void *                   context;
+#if NLDUMPBYTES_USE_PTHREADS
+    pthread_mutex_t          lock;
+    pthread_cond_t           cond;
+    size_t                   num_workers;
+    bool                     go;
+    char *                   buffers[NLDUMPBYTES_PARALLEL_MAX_TASKS][2];
+    size_t                   starts[NLDUMPBYTES_PARALLEL_MAX_TASKS][2];
+    size_t                   lens[NLDUMPBYTES_PARALLEL_MAX_TASKS][2];
+    bool                     ready[NLDUMPBYTES_PARALLEL_MAX_TASKS][2];
+#endif
+} nl_dump_parallel_job_t;
+
+static void nl_dump_parallel_append(const char *inChars, size_t inLen, void *inContext)
+{
+    nl_dump_parallel_output_t *output = (nl_dump_parallel_output_t *)inContext;
+
+    memcpy(&output->buffer[output->len], inChars, inLen);
+    output->len += inLen;
+}
+
+// Format one slice of the file into buffer, exactly as it appears in the
+// dump of the whole file, and return the offset in buffer at which the
+// formatting starts, with its length in *len.
+//
+// Whether a line is squeezed depends only on it and the line before,
+// but whether a "*" is written for it depends on whether that line was
+// squeezed too. So, when squeezing, each slice but the first is
+// formatted from the line before it, which is then dropped, along with
+// any "*" that follows it if the slice before already wrote that.
+
+static size_t nl_dump_parallel_format(const nl_dump_parallel_job_t *job, size_t slice, char *buffer, size_t *len)
+{
+    const size_t start = slice * NLDUMPBYTES_PARALLEL_SLICE_BYTES;
+    const size_t num   = (job->size - start < NLDUMPBYTES_PARALLEL_SLICE_BYTES) ?
+        job->size - start : NLDUMPBYTES_PARALLEL_SLICE_BYTES;
+    const uint8_t flags = (start + num < job->size) ?
+        (uint8_t)(job->flags | NLDUMPBYTES_FLAG_CONTINUED) : job->flags;
+    nl_dump_parallel_output_t output;
+    size_t skip = 0;
+
+    output.buffer = buffer;
+    output.len    = 0;
+
+    if ((job->flags & NLDUMPBYTES_FLAG_SQUEEZE) && start > 0)
+    {
+        nl_dump_bytes_flags(job->offs + start - 16, &job->bytes[start - 16], num + 16, flags,
+                            nl_dump_parallel_append, &output);
+
+        skip = (size_t)((const char *)memchr(buffer, '\n', output.len) - buffer) + 1;
+
+        if (start >= 32 && memcmp(&job->bytes[start - 16], &job->bytes[start - 32], 16) == 0 &&
+            skip < output.len && buffer[skip] == '*')
+        {
+            skip += 2;
+        }
+    }
+    else
+    {
+        nl_dump_bytes_flags(job->offs + start, &job->bytes[start], num, flags,
+                            nl_dump_parallel_append, &output);
+    }
+
+    *len = output.len - skip;
+
+    return skip;
+}
+
+#if NLDUMPBYTES_USE_PTHREADS
+typedef struct {
+    nl_dump_parallel_job_t *job;
+    size_t                  index;
+} nl_dump_parallel_thread_t;
+
+// Each worker formats every num_workers-th slice, starting with its
+// own index, alternating between its two buffers, each of which it
+// waits on until the calling thread has written it out.
+
+static void *nl_dump_parallel_worker(void *inArgument)
+{
+    nl_dump_parallel_thread_t *thread = (nl_dump_parallel_thread_t *)inArgument;
+    nl_dump_parallel_job_t    *job    = thread->job;
+    const size_t               index  = thread->index;
+    size_t                     slice;
+    size_t                     k;
+
+    pthread_mutex_lock(&job->lock);
+
+    while (!job->go)
+        pthread_cond_wait(&job->cond, &job->lock);
+
+    pthread_mutex_unlock(&job->lock);
+
+    if (index >= job->num_workers)
+        return NULL;
+
+    for (k = 0; (slice = index + k * job->num_workers) < job->num_slices; k++)
+    {
+        const size_t slot = k & 1;
+        size_t       start;
+        size_t       len;
+
+        pthread_mutex_lock(&job->lock);
+
+        while (job->ready[index][slot])
+            pthread_cond_wait(&job->cond, &job->lock);
+
+        pthread_mutex_unlock(&job->lock);
+
+        start = nl_dump_parallel_format(job, slice, job->buffers[index][slot], &len);
+
+        pthread_mutex_lock(&job->lock);
+
+        job->starts[index][slot] = start;
+        job->lens[index][slot]   = len;
+        job->ready[index][slot]  = true;
+
+        pthread_cond_broadcast(&job->cond);
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    return NULL;
+}
+
+// Start up to num_tasks workers and write their slices out in order on
+// the calling thread. Returns false, having written nothing, if no
+// worker could be started.
+
+static bool nl_dump_parallel_run(nl_dump_parallel_job_t *job, size_t num_tasks)
+{
+    nl_dump_parallel_thread_t threads[NLDUMPBYTES_PARALLEL_MAX_TASKS];
+    pthread_t                 ids[NLDUMPBYTES_PARALLEL_MAX_TASKS];
+    size_t                    started = 0;
+    size_t                    slice;
+    size_t                    i;
+
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->cond, NULL);
+
+    job->go = false;
+
+    for (i = 0; i < num_tasks; i++)
+    {
+        job->buffers[i][0] = (char *)malloc(NLDUMPBYTES_PARALLEL_BUFFER_SIZE);
+        job->buffers[i][1] = (char *)malloc(NLDUMPBYTES_PARALLEL_BUFFER_SIZE);
+        job->ready[i][0]   = false;
+        job->ready[i][1]   = false;
+
+        threads[i].job   = job;
+        threads[i].index = i;
+
+        if (job->buffers[i][0] == NULL || job->buffers[i][1] == NULL ||
+            pthread_create(&ids[i], NULL, nl_dump_parallel_worker, &threads[i]) != 0)
+        {
+            free(job->buffers[i][0]);
+            free(job->buffers[i][1]);
+            break;
+        }
+
+        started++;
+    }
+
+    // Only now that the number of workers is known can each work out
+    // which slices are its own.
+
+    pthread_mutex_lock(&job->lock);
+
+    job->num_workers = started;
+    job->go          = true;
+
+    pthread_cond_broadcast(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+
+    for (slice = 0; started > 0 && slice < job->num_slices; slice++)
+    {
+        const size_t index = slice % started;
+        const size_t slot  = (slice / started) & 1;
+
+        pthread_mutex_lock(&job->lock);
+
+        while (!job->ready[index][slot])
+            pthread_cond_wait(&job->cond, &job->lock);
+
+        pthread_mutex_unlock(&job->lock);
+
+        job->out_write(&job->buffers[index][slot][job->starts[index][slot]], job->lens[index][slot], job->context);
+
+        pthread_mutex_lock(&job->lock);
+
+        job->ready[index][slot] = false;
+
+        pthread_cond_broadcast(&job->cond);
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    for (i = 0; i < started; i++)
+    {
+        pthread_join(ids[i], NULL);
+
+        free(job->buffers[i][0]);
+        free(job->buffers[i][1]);
+    }
+
+    pthread_cond_destroy(&job->cond);
+    pthread_mutex_destroy(&job->lock);
+
+    return (started > 0);
+}
+#endif /* NLDUMPBYTES_USE_PTHREADS */
+
+// Format and write the slices in order on the calling thread.
+
+static int nl_dump_parallel_sequential(nl_dump_parallel_job_t *job)
+{
+    char * const buffer = (char *)malloc(NLDUMPBYTES_PARALLEL_BUFFER_SIZE);
+    size_t       slice;
+    size_t       start;
+    size_t       len;
+
+    if (buffer == NULL)
+        return -1;
+
+    for (slice = 0; slice < job->num_slices; slice++)
+    {
+        start = nl_dump_parallel_format(job, slice, buffer, &len);
+
+        job->out_write(&buffer[start], len, job->context);
+    }
+
+    free(buffer);
+
+    return 0;
+}
+#endif /* NLDUMPBYTES_USE_MMAP */
+
+int nl_dump_file_parallel(int fd, uintptr_t offs, uint8_t flags, size_t num_tasks,
+                          nl_dump_bytes_write_t out_write, void *context)
+{
+#if NLDUMPBYTES_USE_MMAP
+    nl_dump_parallel_job_t job;
+    struct stat            status;
+    void *                 map;
+    int                    retval = 0;
+
+    if (fstat(fd, &status) != 0)
+        return -1;
+
+    if (!S_ISREG(status.st_mode))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (status.st_size == 0)
+        return 0;
+
+    if ((uintmax_t)status.st_size > SIZE_MAX)
+    {
+        errno = EFBIG;
+        return -1;
+    }
+
+    map = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map == MAP_FAILED)
+        return -1;
+
+#if defined(MADV_SEQUENTIAL)
+    madvise(map, (size_t)status.st_size, MADV_SEQUENTIAL);
+#endif
+
+    job.bytes      = (const uint8_t *)map;
+    job.size       = (size_t)status.st_size;
+    job.offs       = offs;
+    job.flags      = flags;
+    job.num_slices = job.size / NLDUMPBYTES_PARALLEL_SLICE_BYTES +
+                     (job.size % NLDUMPBYTES_PARALLEL_SLICE_BYTES != 0);
+    job.out_write  = out_write;
+    job.context    = context;
+
+    if (num_tasks == 0)
+    {
+#if NLDUMPBYTES_USE_PTHREADS && defined(_SC_NPROCESSORS_ONLN)
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        num_tasks = (cpus > 0) ? (size_t)cpus : 1;
+#else
+        num_tasks = 1;
+#endif
+    }
+
+    if (num_tasks > NLDUMPBYTES_PARALLEL_MAX_TASKS)
+        num_tasks = NLDUMPBYTES_PARALLEL_MAX_TASKS;
+
+    if (num_tasks > job.num_slices)
+        num_tasks = job.num_slices;
+
+#if NLDUMPBYTES_USE_PTHREADS
+    if (num_tasks <= 1 || !nl_dump_parallel_run(&job, num_tasks))
+        retval = nl_dump_parallel_sequential(&job);
+#else
+    retval = nl_dump_parallel_sequential(&job);
+#endif
+
+    munmap(map, job.size);
+
+    return retval;
+#else
+    NL_UNUSED(fd);
+    NL_UNUSED(offs);
+    NL_UNUSED(flags);
+    NL_UNUSED(num_tasks);
+    NL_UNUSED(out_write);
+    NL_UNUSED(context);
+
+    errno = ENOSYS;
+    return -1;
+#endif /* NLDUMPBYTES_USE_MMAP */
+}
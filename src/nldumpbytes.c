@@ -19,51 +19,336 @@
 /**
  *    @file
  *      This file implements a method to print-print a block of memory
- *      to standard output.
+ *      to standard output, a stdio stream, a file descriptor, a
+ *      caller buffer, or a caller write function.
  *
  */
 
 #include <nlutilities.h>
+#include <nlutilities-stdio.h>
 
-#include <ctype.h>
-#include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
-void nl_dump_bytes(uintptr_t offs, const uint8_t *bytes, size_t num)
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#include "nlutilities-internal.h"
+
+/**
+ *  @def NLDUMPBYTES_LINES_PER_WRITE
+ *
+ *  @brief
+ *    The number of lines that are formatted into a buffer on the stack
+ *    before being passed to the write function in a single call. Each
+ *    line takes at most NLDUMPBYTES_LINE_MAX characters.
+ */
+#ifndef NLDUMPBYTES_LINES_PER_WRITE
+#define NLDUMPBYTES_LINES_PER_WRITE 32
+#endif /* NLDUMPBYTES_LINES_PER_WRITE */
+
+/**
+ *  @def NLDUMPBYTES_USE_SSE2
+ *
+ *  @brief
+ *    The SSE2 build feature compares lines for squeezing and diffing
+ *    with a single 16-byte vector compare. It is enabled by default
+ *    whenever the compiler targets SSE2.
+ */
+#ifndef NLDUMPBYTES_USE_SSE2
+#if defined(__SSE2__)
+#define NLDUMPBYTES_USE_SSE2 1
+#else
+#define NLDUMPBYTES_USE_SSE2 0
+#endif
+#endif /* NLDUMPBYTES_USE_SSE2 */
+
+#if NLDUMPBYTES_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+static const char nl_dump_bytes_digits[] = "0123456789ABCDEF";
+
+// The column of each byte's digits, nl_dump_bytes_hex_width() of its
+// index.
+
+static const uint8_t nl_dump_bytes_columns[16] = {
+     0,  3,  6,  9, 13, 16, 19, 22, 27, 30, 33, 36, 40, 43, 46, 49
+};
+
+// The width of the hexadecimal columns of a line of n bytes: each byte
+// is followed by a space, each group of four by another, and the first
+// eight by yet another.
+
+static inline size_t nl_dump_bytes_hex_width(size_t n)
 {
+    return n * 3 + n / 4 + (n >= 8 ? 1 : 0);
+}
+
+// Format an offset exactly as printf("%08"PRIXPTR, offs) would.
+//
+// Returns the number of characters written.
+//
+static inline size_t nl_dump_bytes_offset(char *dest, uintptr_t offs)
+{
+    size_t width = 8;
     size_t i;
-    char lineBuf[17];
 
-    while (num > 0)
+    while (width < sizeof (uintptr_t) * 2 && (offs >> (width * 4)) != 0)
+        width++;
+
+    if (width == 8)
     {
-        const size_t thisGo = (num >= 16 ? 16 : num);
+        memcpy(&dest[0], nl_bintohex_pairs[0][(offs >> 24) & 0xff], 2);
+        memcpy(&dest[2], nl_bintohex_pairs[0][(offs >> 16) & 0xff], 2);
+        memcpy(&dest[4], nl_bintohex_pairs[0][(offs >>  8) & 0xff], 2);
+        memcpy(&dest[6], nl_bintohex_pairs[0][(offs >>  0) & 0xff], 2);
+    }
+    else
+    {
+        for (i = width; i > 0; i--)
+        {
+            dest[i - 1] = nl_dump_bytes_digits[offs & 0xf];
+            offs >>= 4;
+        }
+    }
 
-        printf("%08"PRIXPTR"  ", offs);
+    return width;
+}
 
-        for (i = 0; i < thisGo; i++)
-        {
-            const uint8_t b = bytes[i];
+// Format one line of up to 16 bytes exactly as
+//
+//   printf("%08"PRIXPTR"  ", offs);
+//
+// followed by the bytes, the characters and a newline would, without
+// any of the calls.
+//
+// Returns the number of characters written, at most
+// NLDUMPBYTES_LINE_MAX.
+//
+static inline size_t nl_dump_bytes_line(char *dest, uintptr_t offs, const uint8_t *bytes, size_t n)
+{
+    char *d = dest;
+    size_t i;
 
-            lineBuf[i] = (!isprint(b)) ? '.' : b;
+    d += nl_dump_bytes_offset(d, offs);
+    *d++ = ' ';
+    *d++ = ' ';
 
-            printf("%.02" PRIX8 " ", b);
+    memset(d, ' ', nl_dump_bytes_hex_width(n));
 
-            if ((i & 3) == 3)
-            {
-                printf(" ");
-            }
-            if (i == 7)
+    for (i = 0; i < n; i++)
+        memcpy(&d[nl_dump_bytes_columns[i]], nl_bintohex_pairs[0][bytes[i]], 2);
+
+    d += nl_dump_bytes_hex_width(n);
+
+    // Printable here is that of isprint in the "C" locale.
+
+    for (i = 0; i < n; i++)
+        d[i] = ((uint8_t)(bytes[i] - 0x20) < 0x5f) ? (char)bytes[i] : '.';
+
+    d += n;
+
+    *d++ = '\n';
+
+    return (size_t)(d - dest);
+}
+
+// Return whether the n bytes of two lines are the same.
+
+static inline bool nl_dump_bytes_equal(const uint8_t *a, const uint8_t *b, size_t n)
+{
+#if NLDUMPBYTES_USE_SSE2
+    if (n == 16)
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)a),
+                                                _mm_loadu_si128((const __m128i *)b))) == 0xffff;
+#endif
+
+    return memcmp(a, b, n) == 0;
+}
+
+void nl_dump_bytes_flags(uintptr_t offs, const uint8_t *bytes, size_t num, uint8_t flags, nl_dump_bytes_write_t out_write, void *context)
+{
+    char buffer[NLDUMPBYTES_LINES_PER_WRITE * NLDUMPBYTES_LINE_MAX];
+    const uint8_t *previous = NULL;
+    bool squeezing = false;
+    size_t len = 0;
+
+    while (num > 0)
+    {
+        const size_t thisGo = (num >= 16 ? 16 : num);
+
+        // A whole line the same as the one before it starts or
+        // continues a run, which is marked by a single "*" line.
+
+        if ((flags & NLDUMPBYTES_FLAG_SQUEEZE) && thisGo == 16 && previous != NULL &&
+            nl_dump_bytes_equal(bytes, previous, 16))
+        {
+            if (!squeezing)
             {
-                printf(" ");
+                buffer[len++] = '*';
+                buffer[len++] = '\n';
+                squeezing = true;
             }
         }
+        else
+        {
+            // Every line but the last is whole, and formatting it with
+            // a constant length lets the compiler unroll it completely.
+
+            if (thisGo == 16)
+                len += nl_dump_bytes_line(&buffer[len], offs, bytes, 16);
+            else
+                len += nl_dump_bytes_line(&buffer[len], offs, bytes, thisGo);
+
+            squeezing = false;
+        }
+
+        previous = bytes;
 
-        lineBuf[i] = 0;
-        printf("%s\n", lineBuf);
         num -= thisGo;
         offs += thisGo;
         bytes += thisGo;
+
+        // As hexdump -C does, close a dump that ends in a run with the
+        // offset just past it, so that its length is not lost.
+
+        if (num == 0 && squeezing && !(flags & NLDUMPBYTES_FLAG_CONTINUED))
+        {
+            len += nl_dump_bytes_offset(&buffer[len], offs);
+            buffer[len++] = '\n';
+        }
+
+        if (len > sizeof (buffer) - NLDUMPBYTES_LINE_MAX || (num == 0 && len > 0))
+        {
+            out_write(buffer, len, context);
+            len = 0;
+        }
+    }
+}
+
+void nl_dump_bytes_write(uintptr_t offs, const uint8_t *bytes, size_t num, nl_dump_bytes_write_t out_write, void *context)
+{
+    nl_dump_bytes_flags(offs, bytes, num, 0, out_write, context);
+}
+
+void nl_dump_bytes_diff(uintptr_t offs, const uint8_t *before, const uint8_t *after, size_t num, nl_dump_bytes_write_t out_write, void *context)
+{
+    char buffer[NLDUMPBYTES_LINES_PER_WRITE * NLDUMPBYTES_LINE_MAX];
+    size_t len = 0;
+
+    while (num > 0)
+    {
+        const size_t thisGo = (num >= 16 ? 16 : num);
+
+        // Only lines that differ are written, as a pair with the line
+        // before marked '-' and the line after marked '+'.
+
+        if (!nl_dump_bytes_equal(before, after, thisGo))
+        {
+            buffer[len++] = '-';
+            len += nl_dump_bytes_line(&buffer[len], offs, before, thisGo);
+            buffer[len++] = '+';
+            len += nl_dump_bytes_line(&buffer[len], offs, after, thisGo);
+        }
+
+        num -= thisGo;
+        offs += thisGo;
+        before += thisGo;
+        after += thisGo;
+
+        if (len > sizeof (buffer) - 2 * (NLDUMPBYTES_LINE_MAX + 1) || (num == 0 && len > 0))
+        {
+            out_write(buffer, len, context);
+            len = 0;
+        }
+    }
+}
+
+typedef struct {
+    char   *buffer;
+    size_t  size;
+    size_t  len;
+} nl_dump_bytes_buffer_context_t;
+
+static void nl_dump_bytes_buffer_write(const char *chars, size_t len, void *context)
+{
+    nl_dump_bytes_buffer_context_t *theContext = (nl_dump_bytes_buffer_context_t *)context;
+
+    if (theContext->len < theContext->size)
+    {
+        const size_t room = theContext->size - theContext->len;
+
+        memcpy(&theContext->buffer[theContext->len], chars, (len < room) ? len : room);
+    }
+
+    theContext->len += len;
+}
+
+size_t nl_dump_bytes_buffer(char *buffer, size_t size, uintptr_t offs, const uint8_t *bytes, size_t num)
+{
+    nl_dump_bytes_buffer_context_t theContext;
+
+    // Leave room for the terminator, as snprintf does.
+
+    theContext.buffer = buffer;
+    theContext.size   = (size > 0) ? size - 1 : 0;
+    theContext.len    = 0;
+
+    nl_dump_bytes_write(offs, bytes, num, nl_dump_bytes_buffer_write, &theContext);
+
+    if (size > 0)
+        buffer[(theContext.len < size - 1) ? theContext.len : size - 1] = '\0';
+
+    return theContext.len;
+}
+
+void nl_dump_bytes_file_write(const char *chars, size_t len, void *context)
+{
+    fwrite(chars, 1, len, (FILE *)context);
+}
+
+void nl_dump_bytes_file(FILE *file, uintptr_t offs, const uint8_t *bytes, size_t num)
+{
+    nl_dump_bytes_write(offs, bytes, num, nl_dump_bytes_file_write, file);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Write everything, across short writes and interruptions, giving up
+// on any other error.
+
+void nl_dump_bytes_fd_write(const char *chars, size_t len, void *context)
+{
+    const int fd = *(const int *)context;
+
+    while (len > 0)
+    {
+        const ssize_t written = write(fd, chars, len);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        chars += written;
+        len -= (size_t)written;
     }
 }
+
+void nl_dump_bytes_fd(int fd, uintptr_t offs, const uint8_t *bytes, size_t num)
+{
+    nl_dump_bytes_write(offs, bytes, num, nl_dump_bytes_fd_write, &fd);
+}
+#endif /* defined(__unix__) || defined(__APPLE__) */
+
+void nl_dump_bytes(uintptr_t offs, const uint8_t *bytes, size_t num)
+{
+    nl_dump_bytes_file(stdout, offs, bytes, num);
+}
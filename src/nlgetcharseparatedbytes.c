@@ -29,6 +29,56 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "nlutilities-internal.h"
+
+// Each character maps to its value as a digit in any base up to 36, or
+// to a value that no base accepts.
+
+#define NLDIGIT_VAL(c)                                          \
+    ((c) >= '0' && (c) <= '9' ? (c) - '0' :                     \
+     (c) >= 'A' && (c) <= 'Z' ? (c) - 'A' + 10 :                \
+     (c) >= 'a' && (c) <= 'z' ? (c) - 'a' + 10 : UINT8_MAX)
+
+static const uint8_t nl_digit_values[256] = {
+    NL_TABLE256(NLDIGIT_VAL)
+};
+
+// Scan the run of plain decimal or hexadecimal digits at the start of
+// a field, which is all that nearly every field is, without the base
+// detection, whitespace and sign handling, locale, and errno of
+// strtoul. Values beyond a byte saturate at 256 rather than growing.
+//
+// Returns whether any digits were scanned; the caller falls back to
+// strtoul for anything else, or anything other than the expected
+// terminator following the digits, so that the result is always what
+// strtoul would have made of the field.
+//
+static inline bool scan_digits(const char *inCurrent, const char **outNext, int inBase, unsigned int *outValue)
+{
+    const char *current = inCurrent;
+    unsigned int val = 0;
+    unsigned int digit;
+
+    if (inBase != 16 && inBase != 10)
+        return false;
+
+    while ((digit = nl_digit_values[(uint8_t)*current]) < (unsigned int)inBase)
+    {
+        val = val * inBase + digit;
+
+        if (val > 255)
+            val = 256;
+
+        current++;
+    }
+
+    *outNext = current;
+    *outValue = val;
+
+    return (current != inCurrent);
+}
 
 int nl_getCharSeparatedBytes(const char* inBuffer,
                           uint8_t* outBytes,
@@ -41,8 +91,14 @@ int nl_getCharSeparatedBytes(const char* inBuffer,
     size_t i;
     for (i = 0; i < inNumValues; i++)
     {
+        const char terminator = (i != (inNumValues-1)) ? inSeparator : '\0';
+        unsigned int val;
+
         current = next;
-        unsigned int val = strtoul(current, (char**) &next, inBase);
+        if (!scan_digits(current, &next, inBase, &val) || (*next != terminator))
+        {
+            val = strtoul(current, (char**) &next, inBase);
+        }
         if ((val > 255)  // out of bound
            ||((i != (inNumValues-1))   // wrong separator
               && (*next != inSeparator))
@@ -63,6 +119,36 @@ int nl_getCharSeparatedBytes(const char* inBuffer,
     return i;
 }
 
+size_t nl_getCharSeparatedBytesBatch(const char* const* inBuffers,
+                                     size_t inNumBuffers,
+                                     uint8_t* outBytes,
+                                     size_t inNumValues,
+                                     char inSeparator,
+                                     int inBase,
+                                     int* outNumParsed)
+{
+    size_t numComplete = 0;
+    size_t i;
+    for (i = 0; i < inNumBuffers; i++)
+    {
+        const int retval = nl_getCharSeparatedBytes(inBuffers[i],
+                                                    &outBytes[i * inNumValues],
+                                                    inNumValues,
+                                                    inSeparator,
+                                                    inBase);
+
+        if (outNumParsed != NULL)
+        {
+            outNumParsed[i] = retval;
+        }
+
+        if ((size_t)retval == inNumValues)
+        {
+            numComplete++;
+        }
+    }
+    return numComplete;
+}
 
 void nl_printBytesWithSeparator( const uint8_t* inBytes, size_t inNumValues, char inSeparator)
 {
@@ -0,0 +1,152 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines the build features and the digit classifiers
+ *      shared by the hexadecimal string decoder and validator.
+ *
+ */
+
+#ifndef NLUTILITIES_NLHEXDIGIT_INTERNAL_H
+#define NLUTILITIES_NLHEXDIGIT_INTERNAL_H
+
+#include <stdint.h>
+
+/**
+ *  @def NLHEXDIGIT_USE_SSE2
+ *
+ *  @brief
+ *    The SSE2 build feature enables classifying 16 characters per
+ *    iteration in nl_strhextobin_checked and nl_isxdigitstrn. It is
+ *    enabled by default whenever the compiler targets SSE2.
+ */
+#ifndef NLHEXDIGIT_USE_SSE2
+#if defined(__SSE2__)
+#define NLHEXDIGIT_USE_SSE2 1
+#else
+#define NLHEXDIGIT_USE_SSE2 0
+#endif
+#endif /* NLHEXDIGIT_USE_SSE2 */
+
+/**
+ *  @def NLHEXDIGIT_USE_AVX2
+ *
+ *  @brief
+ *    The AVX2 build feature enables classifying 32 characters per
+ *    iteration in nl_strhextobin_checked and nl_isxdigitstrn. It is
+ *    enabled by default whenever the compiler targets AVX2 (for
+ *    example, with -mavx2 or -march=native).
+ */
+#ifndef NLHEXDIGIT_USE_AVX2
+#if defined(__AVX2__)
+#define NLHEXDIGIT_USE_AVX2 1
+#else
+#define NLHEXDIGIT_USE_AVX2 0
+#endif
+#endif /* NLHEXDIGIT_USE_AVX2 */
+
+#if NLHEXDIGIT_USE_AVX2
+#include <immintrin.h>
+#elif NLHEXDIGIT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Each range of digits is tested as an unsigned offset from its first
+// character. Setting bit 5 folds upper-case letters onto lower-case
+// ones, and nothing else onto them.
+
+// Return the value of a hexadecimal digit of either case, or -1 if the
+// character is not one.
+
+static inline int nl_hexdigit_value(char c)
+{
+    const uint8_t digit = (uint8_t)(c - '0');
+    const uint8_t alpha = (uint8_t)((c | 0x20) - 'a');
+
+    if (digit < 10)
+        return digit;
+    else if (alpha < 6)
+        return alpha + 10;
+
+    return -1;
+}
+
+#if NLHEXDIGIT_USE_SSE2
+// Set each byte of an offset that is at most last, which is when
+// clamping it to last leaves it unchanged.
+
+static inline __m128i nl_hexdigit_in_range(__m128i offset, char last)
+{
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(last)), offset);
+}
+
+// Set each byte of 16 characters that is a hexadecimal digit.
+
+static inline __m128i nl_hexdigit_mask(__m128i chars)
+{
+    return _mm_or_si128(nl_hexdigit_in_range(_mm_sub_epi8(chars, _mm_set1_epi8('0')), 9),
+                        nl_hexdigit_in_range(_mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                                                          _mm_set1_epi8('a')), 5));
+}
+
+// Convert 16 characters as nl_hexdigit_value does, but mapping each
+// that is not a digit to a byte with its high bit set.
+
+static inline __m128i nl_hexdigit_values(__m128i chars)
+{
+    const __m128i digit    = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    const __m128i alpha    = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i is_digit = nl_hexdigit_in_range(digit, 9);
+    const __m128i is_alpha = nl_hexdigit_in_range(alpha, 5);
+    const __m128i values   = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                                          _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+
+    return _mm_or_si128(values, _mm_andnot_si128(_mm_or_si128(is_digit, is_alpha), _mm_set1_epi8((char)0x80)));
+}
+#endif /* NLHEXDIGIT_USE_SSE2 */
+
+#if NLHEXDIGIT_USE_AVX2
+// The AVX2 counterparts of the above, 32 characters at a time.
+
+static inline __m256i nl_hexdigit_in_range_avx2(__m256i offset, char last)
+{
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(last)), offset);
+}
+
+static inline __m256i nl_hexdigit_mask_avx2(__m256i chars)
+{
+    return _mm256_or_si256(nl_hexdigit_in_range_avx2(_mm256_sub_epi8(chars, _mm256_set1_epi8('0')), 9),
+                           nl_hexdigit_in_range_avx2(_mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)),
+                                                                     _mm256_set1_epi8('a')), 5));
+}
+
+static inline __m256i nl_hexdigit_values_avx2(__m256i chars)
+{
+    const __m256i digit    = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    const __m256i alpha    = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    const __m256i is_digit = nl_hexdigit_in_range_avx2(digit, 9);
+    const __m256i is_alpha = nl_hexdigit_in_range_avx2(alpha, 5);
+    const __m256i values   = _mm256_or_si256(_mm256_and_si256(is_digit, digit),
+                                             _mm256_and_si256(is_alpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+
+    return _mm256_or_si256(values, _mm256_andnot_si256(_mm256_or_si256(is_digit, is_alpha), _mm256_set1_epi8((char)0x80)));
+}
+#endif /* NLHEXDIGIT_USE_AVX2 */
+
+#endif /* NLUTILITIES_NLHEXDIGIT_INTERNAL_H */
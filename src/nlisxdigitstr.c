@@ -18,8 +18,9 @@
 
 /**
  *    @file
- *      This file implements a function that determines whether a
- *      NULL-terminated C string conforms to isxdigit.
+ *      This file implements functions that determine whether a
+ *      NULL-terminated C string conforms to isxdigit and how much of
+ *      a counted string consists of hexadecimal digits.
  *
  */
 
@@ -28,6 +29,8 @@
 #include <ctype.h>
 #include <stdbool.h>
 
+#include "nlhexdigit-internal.h"
+
 bool nl_isxdigitstr(const char *s)
 {
     int c;
@@ -42,3 +45,32 @@ bool nl_isxdigitstr(const char *s)
 
     return retval;
 }
+
+size_t nl_isxdigitstrn(const char *s, size_t len)
+{
+    size_t i = 0;
+
+#if NLHEXDIGIT_USE_AVX2
+    for (; i + 32 <= len; i += 32)
+    {
+        const uint32_t invalid = ~(uint32_t)_mm256_movemask_epi8(nl_hexdigit_mask_avx2(_mm256_loadu_si256((const __m256i *)&s[i])));
+
+        if (invalid != 0)
+            return i + CTZ(invalid);
+    }
+#endif
+#if NLHEXDIGIT_USE_SSE2
+    for (; i + 16 <= len; i += 16)
+    {
+        const uint32_t invalid = ~(uint32_t)_mm_movemask_epi8(nl_hexdigit_mask(_mm_loadu_si128((const __m128i *)&s[i]))) & 0xffff;
+
+        if (invalid != 0)
+            return i + CTZ(invalid);
+    }
+#endif
+
+    while (i < len && nl_hexdigit_value(s[i]) >= 0)
+        i++;
+
+    return i;
+}
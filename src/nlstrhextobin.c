@@ -25,11 +25,124 @@
 
 #include <nlutilities.h>
 
+#include "nlhexdigit-internal.h"
+
+#if NLHEXDIGIT_USE_SSE2
+// Combine the high nibble in the even byte and the low nibble in the
+// odd byte of each 16-bit lane into the low byte of that lane.
+
+static inline __m128i nl_hextobin_combine(__m128i nibbles)
+{
+    return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4),
+                        _mm_srli_epi16(nibbles, 8));
+}
+
+// Decode as many whole 32-digit blocks as are available in the input,
+// stopping at the first block containing a character that is not a
+// hexadecimal digit.
+//
+// Returns the number of bytes written; the number of digits consumed
+// is twice that.
+//
+static size_t nl_hextobin_sse2(uint8_t *bin, const char *hex, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= len; i += 16)
+    {
+        const __m128i first  = nl_hexdigit_values(_mm_loadu_si128((const __m128i *)&hex[i * 2]));
+        const __m128i second = nl_hexdigit_values(_mm_loadu_si128((const __m128i *)&hex[i * 2 + 16]));
+
+        if (_mm_movemask_epi8(_mm_or_si128(first, second)) != 0)
+            break;
+
+        _mm_storeu_si128((__m128i *)&bin[i], _mm_packus_epi16(nl_hextobin_combine(first),
+                                                              nl_hextobin_combine(second)));
+    }
+
+    return i;
+}
+#endif /* NLHEXDIGIT_USE_SSE2 */
+
+#if NLHEXDIGIT_USE_AVX2
+// The AVX2 counterparts of the above, 64 digits to 32 bytes at a time.
+
+static inline __m256i nl_hextobin_combine_avx2(__m256i nibbles)
+{
+    return _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00ff)), 4),
+                           _mm256_srli_epi16(nibbles, 8));
+}
+
+static size_t nl_hextobin_avx2(uint8_t *bin, const char *hex, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i + 32 <= len; i += 32)
+    {
+        const __m256i first  = nl_hexdigit_values_avx2(_mm256_loadu_si256((const __m256i *)&hex[i * 2]));
+        const __m256i second = nl_hexdigit_values_avx2(_mm256_loadu_si256((const __m256i *)&hex[i * 2 + 32]));
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(first, second)) != 0)
+            break;
+
+        // The pack interleaves the 128-bit lanes of its operands, which
+        // the permute puts back in order.
+
+        _mm256_storeu_si256((__m256i *)&bin[i],
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(nl_hextobin_combine_avx2(first),
+                                                                         nl_hextobin_combine_avx2(second)),
+                                                     0xd8));
+    }
+
+    return i;
+}
+#endif /* NLHEXDIGIT_USE_AVX2 */
+
+// Every block is loaded before any of its bytes is stored, and each
+// byte is stored at or before the first digit it was decoded from, so
+// decoding in place, with bin equal to hex, never reads a digit that
+// has already been overwritten.
+
+size_t nl_strhextobin_checked(uint8_t *bin, const char *hex, size_t len)
+{
+    size_t i = 0;
+
+#if NLHEXDIGIT_USE_AVX2
+    i = nl_hextobin_avx2(bin, hex, len);
+#endif
+#if NLHEXDIGIT_USE_SSE2
+    i += nl_hextobin_sse2(&bin[i], &hex[i * 2], len - i);
+#endif
+
+    // Finish the tail, or locate the invalid character in the block at
+    // which the vectorized decoder stopped.
+
+    for (; i < len; i++)
+    {
+        const int high = nl_hexdigit_value(hex[i * 2 + 0]);
+        const int low  = nl_hexdigit_value(hex[i * 2 + 1]);
+
+        if (high < 0)
+            return i * 2;
+        else if (low < 0)
+            return i * 2 + 1;
+
+        bin[i] = (uint8_t)(high << 4 | low);
+    }
+
+    return len * 2;
+}
+
+// Decode whatever validates in bulk and fall back to nl_hextobin, and
+// its treatment of invalid characters, only from the first of those.
+
 void nl_strhextobin(uint8_t *bin, const char *hex, size_t len)
 {
     size_t i;
 
-    for (i = 0; i < len; i++) {
+    i = nl_strhextobin_checked(bin, hex, len) / 2;
+
+    for (; i < len; i++) {
         bin[i] = (nl_hextobin(hex[i * 2 + 0]) << 4 |
                   nl_hextobin(hex[i * 2 + 1]) << 0);
     }
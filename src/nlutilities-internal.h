@@ -0,0 +1,73 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines macros and interfaces shared by the Nest Labs
+ *      Utilities implementation but not part of its public interface.
+ *
+ */
+
+#ifndef NLUTILITIES_NLUTILITIES_INTERNAL_H
+#define NLUTILITIES_NLUTILITIES_INTERNAL_H
+
+/*
+ * Expand to the comma-separated initializers f(0) through f(255), or
+ * f(0) through f(4095), for a lookup table that the compiler builds
+ * into read-only data. f must be a constant expression of its argument.
+ */
+#define NL_TABLE16(f, b) \
+    f((b) +  0), f((b) +  1), f((b) +  2), f((b) +  3), f((b) +  4), f((b) +  5), f((b) +  6), f((b) +  7), \
+    f((b) +  8), f((b) +  9), f((b) + 10), f((b) + 11), f((b) + 12), f((b) + 13), f((b) + 14), f((b) + 15)
+
+#define NL_TABLE256_AT(f, b) \
+    NL_TABLE16(f, (b) +   0), NL_TABLE16(f, (b) +  16), NL_TABLE16(f, (b) +  32), NL_TABLE16(f, (b) +  48), \
+    NL_TABLE16(f, (b) +  64), NL_TABLE16(f, (b) +  80), NL_TABLE16(f, (b) +  96), NL_TABLE16(f, (b) + 112), \
+    NL_TABLE16(f, (b) + 128), NL_TABLE16(f, (b) + 144), NL_TABLE16(f, (b) + 160), NL_TABLE16(f, (b) + 176), \
+    NL_TABLE16(f, (b) + 192), NL_TABLE16(f, (b) + 208), NL_TABLE16(f, (b) + 224), NL_TABLE16(f, (b) + 240)
+
+#define NL_TABLE256(f) NL_TABLE256_AT(f, 0)
+
+#define NL_TABLE4096(f) \
+    NL_TABLE256_AT(f,    0), NL_TABLE256_AT(f,  256), NL_TABLE256_AT(f,  512), NL_TABLE256_AT(f,  768), \
+    NL_TABLE256_AT(f, 1024), NL_TABLE256_AT(f, 1280), NL_TABLE256_AT(f, 1536), NL_TABLE256_AT(f, 1792), \
+    NL_TABLE256_AT(f, 2048), NL_TABLE256_AT(f, 2304), NL_TABLE256_AT(f, 2560), NL_TABLE256_AT(f, 2816), \
+    NL_TABLE256_AT(f, 3072), NL_TABLE256_AT(f, 3328), NL_TABLE256_AT(f, 3584), NL_TABLE256_AT(f, 3840)
+
+/*
+ * The two hexadecimal digits of each byte, indexed by whether they are
+ * lower case, then by the byte. Defined in nlbintohex.c.
+ */
+extern const char nl_bintohex_pairs[2][256][2];
+
+/*
+ * The longest line nl_dump_bytes formats: the offset, two spaces, 16
+ * bytes of 2 digits and a space each, 5 more spaces between groups, 16
+ * characters and a newline.
+ */
+#define NLDUMPBYTES_LINE_MAX (sizeof (uintptr_t) * 2 + 2 + 16 * 3 + 5 + 16 + 1)
+
+/*
+ * A flag for nl_dump_bytes_flags, alongside the public
+ * NLDUMPBYTES_FLAG_* flags, for formatting a dump in pieces: the bytes
+ * continue past these, so a trailing squeezed run is not closed with
+ * an offset line.
+ */
+#define NLDUMPBYTES_FLAG_CONTINUED 0x80
+
+#endif /* NLUTILITIES_NLUTILITIES_INTERNAL_H */
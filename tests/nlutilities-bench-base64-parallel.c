@@ -0,0 +1,133 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a benchmark of the throughput of the Nest
+ *      Labs Utilities parallel Base64 encoder and decoder against the
+ *      number of tasks the work is split into.
+ *
+ *      It is built and run by the 'bench' target rather than 'check'.
+ *      An optional argument gives the size of the input in MiB.
+ *
+ */
+
+#include <nlbase64.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_MEBIBYTES 64
+#define REPEATS           3
+
+static double Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t tasks[] = { 1, 2, 4, 8, 0 };
+    const size_t size = (size_t)((argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_MEBIBYTES) << 20;
+    const size_t encoded_size = nl_base64_encoded_len(size, true);
+    uint8_t *input = (uint8_t *)malloc(size);
+    char *expected = (char *)malloc(encoded_size);
+    char *output = (char *)malloc(encoded_size);
+    uint8_t *decoded = (uint8_t *)malloc(size);
+    double encode_base = 0, decode_base = 0;
+    size_t i, j;
+    int status = EXIT_SUCCESS;
+
+    if (size == 0 || input == NULL || expected == NULL || output == NULL || decoded == NULL)
+    {
+        fprintf(stderr, "cannot allocate %zu bytes to code\n", size);
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < size; i++)
+        input[i] = (uint8_t)(i * 131 + (i >> 8));
+
+    nl_base64_encode_ex(input, size, expected);
+
+    printf("%zu MiB, best of %d, in MB/s (speedup over 1 task):\n", size >> 20, REPEATS);
+
+    for (i = 0; i < sizeof (tasks) / sizeof (tasks[0]); i++)
+    {
+        double encode_best = 0, decode_best = 0;
+        size_t encoded = 0, result = 0;
+
+        for (j = 0; j < REPEATS; j++)
+        {
+            double start, encode_time, decode_time;
+
+            start = Now();
+            encoded = nl_base64_encode_parallel(input, size, output, tasks[i], NULL, NULL);
+            encode_time = Now() - start;
+
+            start = Now();
+            result = nl_base64_decode_parallel(output, encoded, decoded, tasks[i], NULL, NULL);
+            decode_time = Now() - start;
+
+            if (j == 0 || encode_time < encode_best)
+                encode_best = encode_time;
+            if (j == 0 || decode_time < decode_best)
+                decode_best = decode_time;
+        }
+
+        // Check the output too, so that a fast wrong answer is not reported.
+
+        if (encoded != encoded_size || memcmp(output, expected, encoded_size) != 0 ||
+            result != size || memcmp(decoded, input, size) != 0)
+        {
+            fprintf(stderr, "tasks %zu: output differs from nl_base64_encode_ex\n", tasks[i]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        encode_best = (double)size / encode_best / 1e6;
+        decode_best = (double)size / decode_best / 1e6;
+
+        if (i == 0)
+        {
+            encode_base = encode_best;
+            decode_base = decode_best;
+        }
+
+        if (tasks[i] == 0)
+            printf("tasks per CPU: ");
+        else
+            printf("tasks %5zu:   ", tasks[i]);
+
+        printf("encode %8.1f (%.2fx)  decode %8.1f (%.2fx)\n",
+               encode_best, encode_best / encode_base, decode_best, decode_best / decode_base);
+    }
+
+    free(decoded);
+    free(output);
+    free(expected);
+    free(input);
+
+    return status;
+}
@@ -0,0 +1,367 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a unit test for the Nest Labs Utilities
+ *      base32 interfaces.
+ *
+ */
+
+#include <nlbase32.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <nlunit-test.h>
+
+struct Base32TestVector
+{
+    const char *decoded;
+    const char *encoded;
+    const char *encoded_hex;
+};
+
+/*
+ * The test vectors of RFC 4648, section 10.
+ */
+static const struct Base32TestVector sBase32Vectors[] = {
+    { "",       "",                 ""                 },
+    { "f",      "MY======",         "CO======"         },
+    { "fo",     "MZXQ====",         "CPNG===="         },
+    { "foo",    "MZXW6===",         "CPNMU==="         },
+    { "foob",   "MZXW6YQ=",         "CPNMUOG="         },
+    { "fooba",  "MZXW6YTB",         "CPNMUOJ1"         },
+    { "foobar", "MZXW6YTBOI======", "CPNMUOJ1E8======" },
+};
+
+/*
+ * Fill a buffer with a deterministic, pseudo-random byte pattern that
+ * exercises every 5-bit value.
+ */
+static void Base32FillPattern(uint8_t *outData, size_t inSize, uint32_t inSeed)
+{
+    size_t i;
+
+    for (i = 0; i < inSize; i++)
+    {
+        inSeed = inSeed * 1103515245 + 12345;
+        outData[i] = (uint8_t)(inSeed >> 16);
+    }
+}
+
+static void TestBase32BlockVectors(nlTestSuite *inSuite, void *inContext)
+{
+    char encoded[32];
+    uint8_t decoded[32];
+    size_t length;
+    size_t expected;
+    size_t i;
+    size_t j;
+    int n;
+
+    for (i = 0; i < sizeof (sBase32Vectors) / sizeof (sBase32Vectors[0]); i++)
+    {
+        const struct Base32TestVector *vector = &sBase32Vectors[i];
+        const size_t decoded_length = strlen(vector->decoded);
+        const size_t encoded_length = strlen(vector->encoded);
+
+        /* Standard and extended hex alphabets, padded. */
+
+        length = nl_base32_encode((const uint8_t *)vector->decoded, decoded_length, encoded, 0);
+        NL_TEST_ASSERT(inSuite, length == encoded_length);
+        NL_TEST_ASSERT(inSuite, length == nl_base32_encoded_len(decoded_length, true));
+        n = memcmp(encoded, vector->encoded, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        length = nl_base32_encode((const uint8_t *)vector->decoded, decoded_length, encoded, NLBASE32_FLAG_HEX);
+        NL_TEST_ASSERT(inSuite, length == encoded_length);
+        n = memcmp(encoded, vector->encoded_hex, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        length = nl_base32_decode(vector->encoded, encoded_length, decoded, 0);
+        NL_TEST_ASSERT(inSuite, length == decoded_length);
+        NL_TEST_ASSERT(inSuite, length == nl_base32_decoded_len(vector->encoded, encoded_length));
+        n = memcmp(decoded, vector->decoded, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        length = nl_base32_decode(vector->encoded_hex, encoded_length, decoded, NLBASE32_FLAG_HEX);
+        NL_TEST_ASSERT(inSuite, length == decoded_length);
+        n = memcmp(decoded, vector->decoded, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        /* Unpadded and lower case, which the decoder accepts as is. */
+
+        expected = strcspn(vector->encoded, "=");
+
+        length = nl_base32_encode((const uint8_t *)vector->decoded, decoded_length, encoded,
+                                  NLBASE32_FLAG_NO_PADDING | NLBASE32_FLAG_LOWER_CASE);
+        NL_TEST_ASSERT(inSuite, length == expected);
+        NL_TEST_ASSERT(inSuite, length == nl_base32_encoded_len(decoded_length, false));
+
+        for (j = 0; j < length; j++)
+            NL_TEST_ASSERT(inSuite, encoded[j] == ((vector->encoded[j] >= 'A') ? vector->encoded[j] + 'a' - 'A' : vector->encoded[j]));
+
+        length = nl_base32_decode(encoded, length, decoded, 0);
+        NL_TEST_ASSERT(inSuite, length == decoded_length);
+        n = memcmp(decoded, vector->decoded, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+}
+
+static void TestBase32BlockLarge(nlTestSuite *inSuite, void *inContext)
+{
+    static const uint8_t flags[] = {
+        0, NLBASE32_FLAG_LOWER_CASE, NLBASE32_FLAG_NO_PADDING, NLBASE32_FLAG_HEX,
+        NLBASE32_FLAG_HEX | NLBASE32_FLAG_LOWER_CASE | NLBASE32_FLAG_NO_PADDING
+    };
+    static uint8_t input[4099];
+    static char encoded[(sizeof (input) + 4) / 5 * 8];
+    static uint8_t decoded[sizeof (input)];
+    size_t length;
+    size_t size;
+    size_t i;
+    int n;
+
+    Base32FillPattern(input, sizeof (input), 3);
+
+    for (i = 0; i < sizeof (flags) / sizeof (flags[0]); i++)
+    {
+        for (size = sizeof (input) - 11; size <= sizeof (input); size++)
+        {
+            length = nl_base32_encode(input, size, encoded, flags[i]);
+            NL_TEST_ASSERT(inSuite, length == nl_base32_encoded_len(size, !(flags[i] & NLBASE32_FLAG_NO_PADDING)));
+
+            length = nl_base32_decode(encoded, length, decoded, flags[i] & NLBASE32_FLAG_HEX);
+            NL_TEST_ASSERT(inSuite, length == size);
+            n = memcmp(decoded, input, size);
+            NL_TEST_ASSERT(inSuite, n == 0);
+        }
+    }
+}
+
+static void TestBase32BlockErrors(nlTestSuite *inSuite, void *inContext)
+{
+    static const char * const invalid[] = {
+        "M",                    /* a lone character */
+        "MZX",                  /* 3 characters leave a character unused */
+        "MZXW6Y",               /* as do 6 */
+        "MZXW6Y==",
+        "MZXW6YTBM",            /* as does 1 after a whole group */
+        "MZXW6Y1B",             /* '1' is not in the standard alphabet */
+        "MZXW6YTB========",     /* padding in place of a group */
+        "MZ XW6YTB",            /* whitespace */
+        "MZXW6YTW",             /* 'W' is not in the extended hex alphabet */
+    };
+    uint8_t decoded[16];
+    size_t length;
+    size_t i;
+
+    for (i = 0; i < sizeof (invalid) / sizeof (invalid[0]); i++)
+    {
+        const uint8_t flags = (i == sizeof (invalid) / sizeof (invalid[0]) - 1) ? NLBASE32_FLAG_HEX : 0;
+
+        length = nl_base32_decode(invalid[i], strlen(invalid[i]), decoded, flags);
+        NL_TEST_ASSERT(inSuite, length == SIZE_MAX);
+    }
+
+    /* Anything after the padding is ignored. */
+
+    length = nl_base32_decode("MZXQ====!", 9, decoded, 0);
+    NL_TEST_ASSERT(inSuite, length == 2);
+}
+
+struct Base32StreamEncodeWriteContext
+{
+    char   *output;
+    size_t  calls;
+};
+
+static void Base32StreamEncodeWrite(const char *inChars, size_t inLen, void *inContext)
+{
+    struct Base32StreamEncodeWriteContext *context = (struct Base32StreamEncodeWriteContext *)(inContext);
+
+    memcpy(context->output, inChars, inLen);
+    context->output += inLen;
+    context->calls++;
+}
+
+static void TestBase32StreamEncoding(nlTestSuite *inSuite, void *inContext)
+{
+    static const uint8_t flags[] = { 0, NLBASE32_FLAG_NO_PADDING | NLBASE32_FLAG_HEX };
+    static uint8_t input[10001];
+    static char output[(sizeof (input) + 4) / 5 * 8];
+    static char expected[(sizeof (input) + 4) / 5 * 8];
+    struct Base32StreamEncodeWriteContext context;
+    nl_base32_stream_enc_state_t state;
+    size_t expected_length;
+    size_t offset;
+    size_t fragment;
+    size_t i;
+    uint64_t written;
+    uint64_t result;
+    int n;
+
+    Base32FillPattern(input, sizeof (input), 6);
+
+    for (i = 0; i < sizeof (flags) / sizeof (flags[0]); i++)
+    {
+        expected_length = nl_base32_encode(input, sizeof (input), expected, flags[i]);
+
+        context.output = output;
+        context.calls  = 0;
+        written        = 0;
+
+        nl_base32_stream_enc_start(&state, flags[i], Base32StreamEncodeWrite, &context);
+
+        for (offset = 0, fragment = 1; offset < sizeof (input); offset += fragment, fragment = (fragment % 97) + 1)
+        {
+            if (fragment > sizeof (input) - offset)
+                fragment = sizeof (input) - offset;
+
+            written += nl_base32_stream_enc_more(&input[offset], fragment, &state);
+            NL_TEST_ASSERT(inSuite, written == (uint64_t)(context.output - output));
+        }
+
+        result = nl_base32_stream_enc_finish(&state);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        NL_TEST_ASSERT(inSuite, (size_t)(context.output - output) == expected_length);
+        n = memcmp(output, expected, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+}
+
+struct Base32StreamWriteContext
+{
+    uint8_t *output;
+    size_t   calls;
+};
+
+static void Base32StreamWrite(const uint8_t *inBytes, size_t inLen, void *inContext)
+{
+    struct Base32StreamWriteContext *context = (struct Base32StreamWriteContext *)(inContext);
+
+    memcpy(context->output, inBytes, inLen);
+    context->output += inLen;
+    context->calls++;
+}
+
+static void TestBase32StreamDecoding(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t expected[20003];
+    static char input[(sizeof (expected) + 4) / 5 * 8];
+    static uint8_t output[sizeof (expected) + 1];
+    struct Base32StreamWriteContext context;
+    nl_base32_stream_dec_state_t state;
+    size_t input_length;
+    size_t offset;
+    size_t fragment;
+    size_t result;
+    size_t total;
+    uint64_t finish;
+    int n;
+
+    Base32FillPattern(expected, sizeof (expected), 9);
+    input_length = nl_base32_encode(expected, sizeof (expected), input, NLBASE32_FLAG_LOWER_CASE);
+
+    /* Fragments of every size from 1 to 97 characters, into a buffer... */
+
+    nl_base32_stream_dec_start(&state, 0, NULL, NULL);
+
+    for (offset = 0, fragment = 1, total = 0; offset < input_length; offset += fragment, fragment = (fragment % 97) + 1)
+    {
+        if (fragment > input_length - offset)
+            fragment = input_length - offset;
+
+        result = nl_base32_stream_dec_more(&input[offset], fragment, &output[total], &state);
+        NL_TEST_ASSERT(inSuite, result != SIZE_MAX);
+        total += result;
+    }
+
+    finish = nl_base32_stream_dec_finish(&state);
+    NL_TEST_ASSERT(inSuite, finish == sizeof (expected));
+    NL_TEST_ASSERT(inSuite, total == sizeof (expected));
+    n = memcmp(output, expected, sizeof (expected));
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* ...and to a write function. */
+
+    memset(output, 0, sizeof (output));
+    context.output = output;
+    context.calls  = 0;
+
+    nl_base32_stream_dec_start(&state, 0, Base32StreamWrite, &context);
+
+    for (offset = 0, fragment = 1; offset < input_length; offset += fragment, fragment = (fragment % 1013) + 1)
+    {
+        if (fragment > input_length - offset)
+            fragment = input_length - offset;
+
+        result = nl_base32_stream_dec_more(&input[offset], fragment, NULL, &state);
+        NL_TEST_ASSERT(inSuite, result != SIZE_MAX);
+    }
+
+    finish = nl_base32_stream_dec_finish(&state);
+    NL_TEST_ASSERT(inSuite, finish == sizeof (expected));
+    NL_TEST_ASSERT(inSuite, (size_t)(context.output - output) == sizeof (expected));
+    n = memcmp(output, expected, sizeof (expected));
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* A partial group that no byte count encodes to is reported by
+     * finish, and invalid characters as soon as they are seen.
+     */
+
+    nl_base32_stream_dec_start(&state, 0, NULL, NULL);
+    result = nl_base32_stream_dec_more("MZXW6YTBM", 9, output, &state);
+    NL_TEST_ASSERT(inSuite, result == 5);
+    NL_TEST_ASSERT(inSuite, nl_base32_stream_dec_finish(&state) == UINT64_MAX);
+
+    nl_base32_stream_dec_start(&state, 0, NULL, NULL);
+    result = nl_base32_stream_dec_more("MZ!", 3, output, &state);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+    result = nl_base32_stream_dec_more("MZ", 2, output, &state);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+    NL_TEST_ASSERT(inSuite, nl_base32_stream_dec_finish(&state) == UINT64_MAX);
+
+    nl_base32_stream_dec_start(&state, 0, NULL, NULL);
+    result = nl_base32_stream_dec_more("MZXW6Y=", 7, output, &state);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+}
+
+static const nlTest sTests[] = {
+    NL_TEST_DEF("base32 block vectors",   TestBase32BlockVectors),
+    NL_TEST_DEF("base32 block large",     TestBase32BlockLarge),
+    NL_TEST_DEF("base32 block errors",    TestBase32BlockErrors),
+    NL_TEST_DEF("base32 stream encoding", TestBase32StreamEncoding),
+    NL_TEST_DEF("base32 stream decoding", TestBase32StreamDecoding),
+    NL_TEST_SENTINEL()
+};
+
+int main(void)
+{
+    nlTestSuite theSuite = {
+        "nlutilities-base32",
+        &sTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    nlTestRunner(&theSuite, NULL);
+
+    return nlTestRunnerStats(&theSuite);
+}
@@ -0,0 +1,210 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a unit test for the Nest Labs Utilities
+ *      C++ base64 encode and decode views.
+ *
+ */
+
+#include <nlbase64.hpp>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <nlunit-test.h>
+
+#if __cplusplus >= 201103L
+
+static void Base64FillPattern(uint8_t *outData, size_t inSize, uint32_t inSeed)
+{
+    size_t i;
+
+    for (i = 0; i < inSize; i++)
+    {
+        inSeed = inSeed * 1103515245 + 12345;
+        outData[i] = static_cast<uint8_t>(inSeed >> 16);
+    }
+}
+
+static void TestBase64EncodeView(nlTestSuite *inSuite, void *inContext)
+{
+    static const uint8_t flags[] = {
+        0, NLBASE64_FLAG_URL_SAFE, NLBASE64_FLAG_NO_PADDING,
+        NLBASE64_FLAG_URL_SAFE | NLBASE64_FLAG_NO_PADDING
+    };
+    uint8_t input[100];
+    char expected[((sizeof (input) + 2) / 3) * 4];
+    char output[sizeof (expected)];
+    size_t expected_length;
+    size_t size;
+    size_t i;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 1);
+
+    for (i = 0; i < sizeof (flags) / sizeof (flags[0]); i++)
+    {
+        for (size = 0; size <= sizeof (input); size++)
+        {
+            const std::vector<uint8_t> bytes(input, input + size);
+            const nl::base64_encode_view<std::vector<uint8_t>::const_iterator> view = nl::base64_encoded(bytes, flags[i]);
+            char *end;
+
+            expected_length = nl_base64_encode_flags(input, size, expected, flags[i]);
+
+            end = std::copy(view.begin(), view.end(), output);
+            NL_TEST_ASSERT(inSuite, static_cast<size_t>(end - output) == expected_length);
+            NL_TEST_ASSERT(inSuite, view.size() == expected_length);
+            n = memcmp(output, expected, expected_length);
+            NL_TEST_ASSERT(inSuite, n == 0);
+        }
+    }
+
+    /* Any input iterator over bytes, into any output iterator. */
+
+    {
+        const std::list<uint8_t> bytes(input, input + 10);
+        std::string encoded;
+        auto view = nl::base64_encoded(bytes.begin(), bytes.end());
+
+        std::copy(view.begin(), view.end(), std::back_inserter(encoded));
+
+        expected_length = nl_base64_encode_flags(input, 10, expected, 0);
+        NL_TEST_ASSERT(inSuite, encoded == std::string(expected, expected_length));
+    }
+}
+
+static void TestBase64DecodeView(nlTestSuite *inSuite, void *inContext)
+{
+    uint8_t input[100];
+    char encoded[((sizeof (input) + 2) / 3) * 4];
+    uint8_t output[sizeof (input)];
+    size_t encoded_length;
+    size_t size;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 2);
+
+    for (size = 0; size <= sizeof (input); size++)
+    {
+        encoded_length = nl_base64_encode_flags(input, size, encoded, (size % 2) ? NLBASE64_FLAG_NO_PADDING : 0);
+
+        auto view = nl::base64_decoded(encoded, encoded + encoded_length);
+        uint8_t *end = std::copy(view.begin(), view.end(), output);
+
+        NL_TEST_ASSERT(inSuite, static_cast<size_t>(end - output) == size);
+        NL_TEST_ASSERT(inSuite, !view.error());
+        n = memcmp(output, input, size);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+
+    /* The URL-safe alphabet, when asked for. */
+
+    {
+        const std::string url("-_-_");
+        auto view = nl::base64_decoded(url, NLBASE64_FLAG_URL_SAFE);
+        const std::vector<uint8_t> bytes(view.begin(), view.end());
+
+        NL_TEST_ASSERT(inSuite, !view.error());
+        NL_TEST_ASSERT(inSuite, bytes.size() == 3 && bytes[0] == 0xFB && bytes[1] == 0xFF && bytes[2] == 0xBF);
+    }
+
+    /* Anything after padding is ignored. */
+
+    {
+        const std::string padded("QUI=QUJD");
+        auto view = nl::base64_decoded(padded);
+        const std::vector<uint8_t> bytes(view.begin(), view.end());
+
+        NL_TEST_ASSERT(inSuite, !view.error());
+        NL_TEST_ASSERT(inSuite, bytes.size() == 2 && bytes[0] == 'A' && bytes[1] == 'B');
+    }
+
+    /* Iteration stops at an error, with the bytes before it decoded. */
+
+    {
+        const std::string invalid("QUJDRA!=");
+        auto view = nl::base64_decoded(invalid);
+        const std::vector<uint8_t> bytes(view.begin(), view.end());
+
+        NL_TEST_ASSERT(inSuite, view.error());
+        NL_TEST_ASSERT(inSuite, bytes.size() == 4 && bytes[3] == 'D');
+    }
+
+    {
+        const std::string truncated("QUJDR");
+        auto view = nl::base64_decoded(truncated);
+        const std::vector<uint8_t> bytes(view.begin(), view.end());
+
+        NL_TEST_ASSERT(inSuite, view.error());
+        NL_TEST_ASSERT(inSuite, bytes.size() == 3);
+    }
+}
+
+static void TestBase64ViewPipeline(nlTestSuite *inSuite, void *inContext)
+{
+    uint8_t input[1000];
+    std::vector<uint8_t> output;
+
+    Base64FillPattern(input, sizeof (input), 3);
+
+    /* Views compose, here decoding an encoding without either ever
+     * being stored.
+     */
+
+    auto encoded = nl::base64_encoded(input, input + sizeof (input), NLBASE64_FLAG_URL_SAFE);
+    auto decoded = nl::base64_decoded(encoded, NLBASE64_FLAG_URL_SAFE);
+
+    std::copy(decoded.begin(), decoded.end(), std::back_inserter(output));
+
+    NL_TEST_ASSERT(inSuite, !decoded.error());
+    NL_TEST_ASSERT(inSuite, output.size() == sizeof (input));
+    NL_TEST_ASSERT(inSuite, std::equal(output.begin(), output.end(), input));
+}
+
+#endif // __cplusplus >= 201103L
+
+static const nlTest sTests[] = {
+#if __cplusplus >= 201103L
+    NL_TEST_DEF("base64 encode view",   TestBase64EncodeView),
+    NL_TEST_DEF("base64 decode view",   TestBase64DecodeView),
+    NL_TEST_DEF("base64 view pipeline", TestBase64ViewPipeline),
+#endif
+    NL_TEST_SENTINEL()
+};
+
+int main(void)
+{
+    nlTestSuite theSuite = {
+        "nlutilities-base64-cxx",
+        &sTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    nlTestRunner(&theSuite, NULL);
+
+    return nlTestRunnerStats(&theSuite);
+}
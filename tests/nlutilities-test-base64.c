@@ -24,11 +24,69 @@
  */
 
 #include <nlbase64.h>
+#include <nlcrc32.h>
 
 #include <string.h>
 
 #include <nlunit-test.h>
 
+static const char sBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*
+ * Straightforward, one group at a time reference encoder against
+ * which the optimized encoders are checked.
+ */
+static size_t Base64ReferenceEncode(const uint8_t *inData, size_t inSize, char *outEncoding)
+{
+    char *start = outEncoding;
+
+    while (inSize >= 3)
+    {
+        *outEncoding++ = sBase64Alphabet[inData[0] >> 2];
+        *outEncoding++ = sBase64Alphabet[((inData[0] << 4) | (inData[1] >> 4)) & 0x3F];
+        *outEncoding++ = sBase64Alphabet[((inData[1] << 2) | (inData[2] >> 6)) & 0x3F];
+        *outEncoding++ = sBase64Alphabet[inData[2] & 0x3F];
+        inData += 3;
+        inSize -= 3;
+    }
+
+    if (inSize > 0)
+    {
+        *outEncoding++ = sBase64Alphabet[inData[0] >> 2];
+
+        if (inSize == 1)
+        {
+            *outEncoding++ = sBase64Alphabet[(inData[0] << 4) & 0x3F];
+            *outEncoding++ = '=';
+        }
+        else
+        {
+            *outEncoding++ = sBase64Alphabet[((inData[0] << 4) | (inData[1] >> 4)) & 0x3F];
+            *outEncoding++ = sBase64Alphabet[(inData[1] << 2) & 0x3F];
+        }
+
+        *outEncoding++ = '=';
+    }
+
+    return outEncoding - start;
+}
+
+/*
+ * Fill a buffer with a deterministic, pseudo-random byte pattern that
+ * exercises every 6-bit value.
+ */
+static void Base64FillPattern(uint8_t *outData, size_t inSize, uint32_t inSeed)
+{
+    size_t i;
+
+    for (i = 0; i < inSize; i++)
+    {
+        inSeed = inSeed * 1103515245 + 12345;
+        outData[i] = (uint8_t)(inSeed >> 16);
+    }
+}
+
 static void TestBase64BlockEncoding(nlTestSuite *inSuite, void *inContext)
 {
     const char *input1 = "The quick brown fox jumped over the lazy dog!";
@@ -67,6 +125,38 @@ static void TestBase64BlockEncoding(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, n == 0);
 }
 
+static void TestBase64BlockEncodingLengths(nlTestSuite *inSuite, void *inContext)
+{
+    uint8_t input[512];
+    char output[((sizeof (input) + 2) / 3) * 4];
+    char expected[((sizeof (input) + 2) / 3) * 4];
+    size_t length;
+    size_t expected_length;
+    uint16_t result;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 1);
+
+    /* Check every length, so that each vector path and each of its
+     * scalar tails is covered, at every input alignment.
+     */
+
+    for (length = 0; length < sizeof (input); length++)
+    {
+        const size_t offset = length % 8;
+
+        if (offset + length > sizeof (input))
+            break;
+
+        expected_length = Base64ReferenceEncode(&input[offset], length, &expected[0]);
+
+        result = nl_base64_encode(&input[offset], length, &output[0]);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        n = memcmp(&output[0], &expected[0], expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+}
+
 static void TestBase64BlockDecoding(nlTestSuite *inSuite, void *inContext)
 {
     const char *input1 = "VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wZWQgb3ZlciB0aGUgbGF6eSBkb2ch";
@@ -107,6 +197,184 @@ static void TestBase64BlockDecoding(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, result == UINT16_MAX);
 }
 
+static void TestBase64BlockAlphabet(nlTestSuite *inSuite, void *inContext)
+{
+    uint8_t group[3 * 16];
+    char input[4];
+    char output[4 * 16];
+    char expected[4 * 16];
+    uint8_t decoded[3];
+    unsigned int value;
+    unsigned int i;
+    unsigned int c;
+    uint16_t result;
+    int n;
+
+    /* Encode every 12-bit value, in both halves of a group, a vector's
+     * worth of groups at a time.
+     */
+
+    for (value = 0; value < 4096; value += 16)
+    {
+        for (i = 0; i < 16; i++)
+        {
+            const uint32_t v = ((value + i) << 12) | (4095 - value - i);
+
+            group[i * 3 + 0] = v >> 16;
+            group[i * 3 + 1] = v >> 8;
+            group[i * 3 + 2] = v;
+        }
+
+        Base64ReferenceEncode(group, sizeof (group), expected);
+
+        result = nl_base64_encode(group, sizeof (group), output);
+        NL_TEST_ASSERT(inSuite, result == sizeof (output));
+        n = memcmp(output, expected, sizeof (output));
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+
+    /* Decode every character value at every position of a group. */
+
+    for (c = 0; c < 256; c++)
+    {
+        const char *found = (c != 0) ? strchr(sBase64Alphabet, c) : NULL;
+
+        for (i = 0; i < 4; i++)
+        {
+            memset(input, 'A', sizeof (input));
+            input[i] = c;
+
+            result = nl_base64_decode(input, sizeof (input), decoded);
+
+            if (found == NULL && !(c == '=' && i >= 2))
+            {
+                NL_TEST_ASSERT(inSuite, result == UINT16_MAX);
+            }
+            else if (found != NULL)
+            {
+                const uint32_t v = (uint32_t)(found - sBase64Alphabet) << (18 - 6 * i);
+
+                NL_TEST_ASSERT(inSuite, result == 3);
+                NL_TEST_ASSERT(inSuite, decoded[0] == (uint8_t)(v >> 16));
+                NL_TEST_ASSERT(inSuite, decoded[1] == (uint8_t)(v >> 8));
+                NL_TEST_ASSERT(inSuite, decoded[2] == (uint8_t)(v));
+            }
+        }
+    }
+}
+
+static void TestBase64BlockDecodingLengths(nlTestSuite *inSuite, void *inContext)
+{
+    uint8_t expected[384];
+    char input[((sizeof (expected) + 2) / 3) * 4];
+    uint8_t output[sizeof (input)];
+    size_t length;
+    size_t input_length;
+    size_t i;
+    uint16_t result;
+    int n;
+
+    Base64FillPattern(expected, sizeof (expected), 2);
+
+    /* Round-trip every length, so that each vector path and each of
+     * its scalar tails, with and without padding, is covered.
+     */
+
+    for (length = 0; length <= sizeof (expected); length++)
+    {
+        input_length = Base64ReferenceEncode(&expected[0], length, &input[0]);
+
+        result = nl_base64_decode(&input[0], input_length, &output[0]);
+        NL_TEST_ASSERT(inSuite, result == length);
+        n = memcmp(&output[0], &expected[0], length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        /* Decode in place. */
+
+        memcpy(&output[0], &input[0], input_length);
+
+        result = nl_base64_decode((const char *)&output[0], input_length, &output[0]);
+        NL_TEST_ASSERT(inSuite, result == length);
+        n = memcmp(&output[0], &expected[0], length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+
+    /* An invalid character at any position must be rejected, whether
+     * it falls in a vector group or in the scalar tail.
+     */
+
+    input_length = Base64ReferenceEncode(&expected[0], 96, &input[0]);
+
+    for (i = 0; i < input_length; i++)
+    {
+        const char saved = input[i];
+
+        input[i] = (i & 1) ? '*' : (char)0xC3;
+
+        result = nl_base64_decode(&input[0], input_length, &output[0]);
+        NL_TEST_ASSERT(inSuite, result == UINT16_MAX);
+
+        input[i] = saved;
+    }
+}
+
+static void TestBase64BlockLarge(nlTestSuite *inSuite, void *inContext)
+{
+    /* Larger than the 16-bit interfaces can describe. */
+
+    static uint8_t input[100003];
+    static char output[((sizeof (input) + 2) / 3) * 4];
+    static char expected[((sizeof (input) + 2) / 3) * 4];
+    static uint8_t decoded[sizeof (input)];
+    size_t expected_length;
+    size_t result;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 3);
+
+    expected_length = Base64ReferenceEncode(input, sizeof (input), expected);
+    NL_TEST_ASSERT(inSuite, expected_length == nl_base64_encoded_len(sizeof (input), true));
+
+    result = nl_base64_encode_ex(input, sizeof (input), output);
+    NL_TEST_ASSERT(inSuite, result == expected_length);
+    n = memcmp(output, expected, expected_length);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len(output, result) == sizeof (input));
+
+    result = nl_base64_decode_ex(output, result, decoded);
+    NL_TEST_ASSERT(inSuite, result == sizeof (input));
+    n = memcmp(decoded, input, sizeof (input));
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    output[expected_length / 2] = '*';
+
+    result = nl_base64_decode_ex(output, expected_length, decoded);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+}
+
+static void TestBase64Lengths(nlTestSuite *inSuite, void *inContext)
+{
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(0, true) == 0);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(1, true) == 4);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(2, true) == 4);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(3, true) == 4);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(4, true) == 8);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(0, false) == 0);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(1, false) == 2);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(2, false) == 3);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(3, false) == 4);
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_len(4, false) == 6);
+
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len("", 0) == 0);
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len("QQ==", 4) == 1);
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len("QQ", 2) == 1);
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len("QUI=", 4) == 2);
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len("QUI", 3) == 2);
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len("QUJD", 4) == 3);
+    NL_TEST_ASSERT(inSuite, nl_base64_decoded_len("QUJDRA==", 8) == 4);
+}
+
 struct Base64StreamPutcharContext
 {
     char *output;
@@ -197,10 +465,1003 @@ static void TestBase64StreamEncoding(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, n == 0);
 }
 
+static void TestBase64StreamEncodingFragments(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t input[70001];
+    static char output[((sizeof (input) + 2) / 3) * 4];
+    static char expected[((sizeof (input) + 2) / 3) * 4];
+    struct Base64StreamPutcharContext context = { output };
+    nl_base64_stream_enc_ex_state_t state;
+    size_t expected_length;
+    size_t offset;
+    size_t fragment;
+    uint64_t written;
+    uint64_t result;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 4);
+
+    expected_length = Base64ReferenceEncode(input, sizeof (input), expected);
+
+    /* Feed the input in fragments of every size from 1 to 600 bytes so
+     * that partial groups are carried across every boundary.
+     */
+
+    nl_base64_stream_enc_ex_start(&state, Base64StreamPutchar, &context);
+
+    written = 0;
+
+    for (offset = 0, fragment = 1; offset < sizeof (input); offset += fragment, fragment = (fragment % 600) + 1)
+    {
+        if (fragment > sizeof (input) - offset)
+            fragment = sizeof (input) - offset;
+
+        written += nl_base64_stream_enc_ex_more(&input[offset], fragment, &state);
+    }
+
+    NL_TEST_ASSERT(inSuite, written == (sizeof (input) / 3) * 4);
+
+    result = nl_base64_stream_enc_ex_finish(true, &state);
+    NL_TEST_ASSERT(inSuite, result == expected_length);
+    NL_TEST_ASSERT(inSuite, (size_t)(context.output - output) == expected_length);
+    n = memcmp(output, expected, expected_length);
+    NL_TEST_ASSERT(inSuite, n == 0);
+}
+
+struct Base64StreamEncodeWriteContext
+{
+    char   *output;
+    size_t  calls;
+};
+
+static void Base64StreamEncodeWrite(const char *inChars, size_t inLen, void *inContext)
+{
+    struct Base64StreamEncodeWriteContext *context = (struct Base64StreamEncodeWriteContext *)(inContext);
+
+    memcpy(context->output, inChars, inLen);
+    context->output += inLen;
+    context->calls++;
+}
+
+static void TestBase64StreamEncodingBuffered(nlTestSuite *inSuite, void *inContext)
+{
+    static const size_t buffer_sizes[] = { 4, 5, 7, 64, 1000 };
+    static uint8_t input[10001];
+    static char output[((sizeof (input) + 2) / 3) * 4];
+    static char expected[((sizeof (input) + 2) / 3) * 4];
+    char buffer[1000];
+    struct Base64StreamEncodeWriteContext context;
+    nl_base64_stream_enc_ex_state_t state;
+    size_t expected_length;
+    size_t offset;
+    size_t fragment;
+    size_t i;
+    uint64_t result;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 6);
+
+    expected_length = Base64ReferenceEncode(input, sizeof (input), expected);
+
+    for (i = 0; i < sizeof (buffer_sizes) / sizeof (buffer_sizes[0]); i++)
+    {
+        context.output = output;
+        context.calls  = 0;
+
+        nl_base64_stream_enc_ex_start_buffered(&state, buffer, buffer_sizes[i], Base64StreamEncodeWrite, &context);
+
+        for (offset = 0, fragment = 1; offset < sizeof (input); offset += fragment, fragment = (fragment % 97) + 1)
+        {
+            if (fragment > sizeof (input) - offset)
+                fragment = sizeof (input) - offset;
+
+            nl_base64_stream_enc_ex_more(&input[offset], fragment, &state);
+        }
+
+        result = nl_base64_stream_enc_ex_finish(true, &state);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        NL_TEST_ASSERT(inSuite, (size_t)(context.output - output) == expected_length);
+        n = memcmp(output, expected, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        /* Each write, other than the last, hands over a buffer that is
+         * too full for another group.
+         */
+
+        NL_TEST_ASSERT(inSuite, context.calls <= expected_length / (buffer_sizes[i] - 3) + 1);
+    }
+}
+
+struct Base64StreamWriteContext
+{
+    uint8_t *output;
+    size_t   calls;
+};
+
+static void Base64StreamWrite(const uint8_t *inBytes, size_t inLen, void *inContext)
+{
+    struct Base64StreamWriteContext *context = (struct Base64StreamWriteContext *)(inContext);
+
+    memcpy(context->output, inBytes, inLen);
+    context->output += inLen;
+    context->calls++;
+}
+
+static void TestBase64StreamDecoding(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t expected[20003];
+    static char input[((sizeof (expected) + 2) / 3) * 4];
+    static uint8_t output[sizeof (expected)];
+    struct Base64StreamWriteContext context = { output, 0 };
+    nl_base64_stream_dec_state_t state;
+    size_t input_length;
+    size_t offset;
+    size_t fragment;
+    size_t result;
+    uint64_t total;
+    uint8_t *cursor;
+    int n;
+
+    Base64FillPattern(expected, sizeof (expected), 5);
+
+    input_length = Base64ReferenceEncode(expected, sizeof (expected), input);
+
+    /* Into a caller buffer, in fragments of every size from 1 to 300
+     * characters so that groups are split at every position.
+     */
+
+    nl_base64_stream_dec_start(&state, NULL, NULL);
+
+    cursor = output;
+
+    for (offset = 0, fragment = 1; offset < input_length; offset += fragment, fragment = (fragment % 300) + 1)
+    {
+        if (fragment > input_length - offset)
+            fragment = input_length - offset;
+
+        result = nl_base64_stream_dec_more(&input[offset], fragment, cursor, &state);
+        NL_TEST_ASSERT(inSuite, result != SIZE_MAX);
+        NL_TEST_ASSERT(inSuite, result <= (fragment * 3 + 3) / 4);
+        cursor += result;
+    }
+
+    total = nl_base64_stream_dec_finish(&state);
+    NL_TEST_ASSERT(inSuite, total == sizeof (expected));
+    NL_TEST_ASSERT(inSuite, (size_t)(cursor - output) == sizeof (expected));
+    n = memcmp(output, expected, sizeof (expected));
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* Into a write function. */
+
+    memset(output, 0, sizeof (output));
+
+    nl_base64_stream_dec_start(&state, Base64StreamWrite, &context);
+
+    for (offset = 0, fragment = 7; offset < input_length; offset += fragment, fragment = (fragment * 3) % 1001)
+    {
+        if (fragment > input_length - offset)
+            fragment = input_length - offset;
+
+        result = nl_base64_stream_dec_more(&input[offset], fragment, NULL, &state);
+        NL_TEST_ASSERT(inSuite, result != SIZE_MAX);
+    }
+
+    total = nl_base64_stream_dec_finish(&state);
+    NL_TEST_ASSERT(inSuite, total == sizeof (expected));
+    NL_TEST_ASSERT(inSuite, (size_t)(context.output - output) == sizeof (expected));
+    NL_TEST_ASSERT(inSuite, context.calls > 1);
+    n = memcmp(output, expected, sizeof (expected));
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* Padding split across fragments; anything after it is ignored. */
+
+    nl_base64_stream_dec_start(&state, NULL, NULL);
+
+    result = nl_base64_stream_dec_more("QUJDR", 5, output, &state);
+    NL_TEST_ASSERT(inSuite, result == 3);
+    result = nl_base64_stream_dec_more("A=", 2, output + 3, &state);
+    NL_TEST_ASSERT(inSuite, result == 1);
+    result = nl_base64_stream_dec_more("=QUJD", 5, output + 4, &state);
+    NL_TEST_ASSERT(inSuite, result == 0);
+    total = nl_base64_stream_dec_finish(&state);
+    NL_TEST_ASSERT(inSuite, total == 4);
+    n = memcmp(output, "ABCD", 4);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* Negative Tests */
+
+    nl_base64_stream_dec_start(&state, NULL, NULL);
+
+    result = nl_base64_stream_dec_more("QUJDR", 5, output, &state);
+    NL_TEST_ASSERT(inSuite, result == 3);
+    total = nl_base64_stream_dec_finish(&state);
+    NL_TEST_ASSERT(inSuite, total == UINT64_MAX);
+
+    nl_base64_stream_dec_start(&state, NULL, NULL);
+
+    result = nl_base64_stream_dec_more("QUJD", 4, output, &state);
+    NL_TEST_ASSERT(inSuite, result == 3);
+    result = nl_base64_stream_dec_more("Q|", 2, output, &state);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+    result = nl_base64_stream_dec_more("QUJD", 4, output, &state);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+    total = nl_base64_stream_dec_finish(&state);
+    NL_TEST_ASSERT(inSuite, total == UINT64_MAX);
+
+    nl_base64_stream_dec_start(&state, NULL, NULL);
+
+    result = nl_base64_stream_dec_more("Q===", 4, output, &state);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+}
+
+/*
+ * Break an encoding into lines of the given length, each ended with the
+ * given terminator, as in PEM and MIME bodies.
+ */
+static size_t Base64WrapLines(const char *inEncoding, size_t inLen, size_t inLineLength,
+                              const char *inTerminator, char *outText)
+{
+    char *start = outText;
+    size_t length;
+
+    while (inLen > 0)
+    {
+        length = (inLen < inLineLength) ? inLen : inLineLength;
+
+        memcpy(outText, inEncoding, length);
+        outText += length;
+        inEncoding += length;
+        inLen -= length;
+
+        memcpy(outText, inTerminator, strlen(inTerminator));
+        outText += strlen(inTerminator);
+    }
+
+    return outText - start;
+}
+
+static void TestBase64WhitespaceDecoding(nlTestSuite *inSuite, void *inContext)
+{
+    static const size_t line_lengths[] = { 64, 76, 4, 30 };
+    static const char *terminators[] = { "\n", "\r\n" };
+    static uint8_t input[4099];
+    static char encoding[((sizeof (input) + 2) / 3) * 4];
+    static char text[sizeof (encoding) * 4];
+    static uint8_t decoded[sizeof (text)];
+    nl_base64_stream_dec_state_t state;
+    size_t encoded_length;
+    size_t text_length;
+    size_t offset;
+    size_t fragment;
+    size_t result;
+    uint64_t total;
+    size_t i;
+    size_t j;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 7);
+
+    encoded_length = nl_base64_encode_ex(input, sizeof (input), encoding);
+
+    for (i = 0; i < sizeof (line_lengths) / sizeof (line_lengths[0]); i++)
+    {
+        for (j = 0; j < sizeof (terminators) / sizeof (terminators[0]); j++)
+        {
+            text_length = Base64WrapLines(encoding, encoded_length, line_lengths[i], terminators[j], text);
+
+            memset(decoded, 0, sizeof (decoded));
+
+            result = nl_base64_decode_ws(text, text_length, decoded);
+            NL_TEST_ASSERT(inSuite, result == sizeof (input));
+            n = memcmp(decoded, input, sizeof (input));
+            NL_TEST_ASSERT(inSuite, n == 0);
+
+            /* Fragments that split lines, terminators and groups. */
+
+            memset(decoded, 0, sizeof (decoded));
+
+            nl_base64_stream_dec_start_ws(&state, NULL, NULL);
+
+            for (offset = 0, total = 0, fragment = 1; offset < text_length; offset += fragment, fragment = fragment % 97 + 1)
+            {
+                if (fragment > text_length - offset)
+                    fragment = text_length - offset;
+
+                result = nl_base64_stream_dec_more(&text[offset], fragment, &decoded[total], &state);
+                NL_TEST_ASSERT(inSuite, result != SIZE_MAX);
+                total += result;
+            }
+
+            total = nl_base64_stream_dec_finish(&state);
+            NL_TEST_ASSERT(inSuite, total == sizeof (input));
+            n = memcmp(decoded, input, sizeof (input));
+            NL_TEST_ASSERT(inSuite, n == 0);
+        }
+    }
+
+    /* Whitespace anywhere, including within groups and padding. */
+
+    result = nl_base64_decode_ws(" QU\tJD\r\nR A\v=\f= \n", 18, decoded);
+    NL_TEST_ASSERT(inSuite, result == 4);
+    n = memcmp(decoded, "ABCD", 4);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    result = nl_base64_decode_ws("\r\n\r\n", 4, decoded);
+    NL_TEST_ASSERT(inSuite, result == 0);
+
+    /* Other characters are still rejected, as is a lone trailing
+     * character, and whitespace is rejected unless asked for.
+     */
+
+    text_length = Base64WrapLines(encoding, encoded_length, 64, "\n", text);
+
+    text[text_length / 2] = '*';
+
+    result = nl_base64_decode_ws(text, text_length, decoded);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+
+    result = nl_base64_decode_ws("QUJDR\n", 6, decoded);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+
+    result = nl_base64_decode_ex("QUJD\n", 5, decoded);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+}
+
+static void TestBase64LineEncoding(nlTestSuite *inSuite, void *inContext)
+{
+    static const size_t line_lengths[] = { 64, 76, 4, 30, 1 };
+    static const char *terminators[] = { "\n", "\r\n" };
+    static const size_t lengths[] = { 0, 1, 2, 3, 47, 48, 49, 57, 1000, 4099 };
+    static uint8_t input[4099];
+    static char encoding[((sizeof (input) + 2) / 3) * 4];
+    static char expected[sizeof (encoding) * 3];
+    static char output[sizeof (encoding) * 3];
+    static char buffer[7];
+    static uint8_t decoded[sizeof (output)];
+    struct Base64StreamPutcharContext putchar_context;
+    struct Base64StreamEncodeWriteContext write_context;
+    nl_base64_stream_enc_ex_state_t state;
+    size_t encoded_length;
+    size_t expected_length;
+    size_t offset;
+    size_t fragment;
+    size_t result;
+    uint64_t total;
+    size_t i;
+    size_t j;
+    size_t k;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 9);
+
+    for (i = 0; i < sizeof (line_lengths) / sizeof (line_lengths[0]); i++)
+    {
+        for (j = 0; j < sizeof (terminators) / sizeof (terminators[0]); j++)
+        {
+            for (k = 0; k < sizeof (lengths) / sizeof (lengths[0]); k++)
+            {
+                encoded_length = nl_base64_encode_ex(input, lengths[k], encoding);
+                expected_length = Base64WrapLines(encoding, encoded_length, line_lengths[i], terminators[j], expected);
+
+                NL_TEST_ASSERT(inSuite, nl_base64_encoded_lines_len(lengths[k], line_lengths[i], strlen(terminators[j])) == expected_length);
+
+                result = nl_base64_encode_lines(input, lengths[k], output, line_lengths[i], terminators[j]);
+                NL_TEST_ASSERT(inSuite, result == expected_length);
+                n = memcmp(output, expected, expected_length);
+                NL_TEST_ASSERT(inSuite, n == 0);
+
+                result = nl_base64_decode_ws(output, result, decoded);
+                NL_TEST_ASSERT(inSuite, result == lengths[k]);
+                n = memcmp(decoded, input, lengths[k]);
+                NL_TEST_ASSERT(inSuite, n == 0);
+
+                /* Streaming, a character at a time and through a staging
+                 * buffer smaller than a line, in fragments that split
+                 * groups and lines.
+                 */
+
+                putchar_context.output = output;
+
+                nl_base64_stream_enc_ex_start(&state, Base64StreamPutchar, &putchar_context);
+                nl_base64_stream_enc_ex_set_lines(&state, line_lengths[i], terminators[j]);
+
+                for (offset = 0, fragment = 1; offset < lengths[k]; offset += fragment, fragment = fragment % 101 + 1)
+                {
+                    if (fragment > lengths[k] - offset)
+                        fragment = lengths[k] - offset;
+
+                    nl_base64_stream_enc_ex_more(&input[offset], fragment, &state);
+                }
+
+                total = nl_base64_stream_enc_ex_finish(true, &state);
+                NL_TEST_ASSERT(inSuite, total == expected_length);
+                n = memcmp(output, expected, expected_length);
+                NL_TEST_ASSERT(inSuite, n == 0);
+
+                write_context.output = output;
+                write_context.calls = 0;
+
+                nl_base64_stream_enc_ex_start_buffered(&state, buffer, sizeof (buffer), Base64StreamEncodeWrite, &write_context);
+                nl_base64_stream_enc_ex_set_lines(&state, line_lengths[i], terminators[j]);
+
+                for (offset = 0, fragment = 1; offset < lengths[k]; offset += fragment, fragment = fragment % 101 + 1)
+                {
+                    if (fragment > lengths[k] - offset)
+                        fragment = lengths[k] - offset;
+
+                    nl_base64_stream_enc_ex_more(&input[offset], fragment, &state);
+                }
+
+                total = nl_base64_stream_enc_ex_finish(true, &state);
+                NL_TEST_ASSERT(inSuite, total == expected_length);
+                NL_TEST_ASSERT(inSuite, (size_t)(write_context.output - output) == expected_length);
+                n = memcmp(output, expected, expected_length);
+                NL_TEST_ASSERT(inSuite, n == 0);
+            }
+        }
+    }
+
+    /* No wrapping. */
+
+    result = nl_base64_encode_lines(input, 100, output, 0, "\n");
+    NL_TEST_ASSERT(inSuite, result == nl_base64_encoded_len(100, true));
+    NL_TEST_ASSERT(inSuite, nl_base64_encoded_lines_len(100, 0, 1) == result);
+}
+
+static void TestBase64UrlSafe(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t input[512];
+    static char standard[((sizeof (input) + 2) / 3) * 4];
+    static char expected[sizeof (standard)];
+    static char output[sizeof (standard)];
+    static uint8_t decoded[sizeof (input)];
+    struct Base64StreamPutcharContext putchar_context;
+    nl_base64_stream_enc_ex_state_t enc_state;
+    nl_base64_stream_dec_state_t dec_state;
+    size_t standard_length;
+    size_t expected_length;
+    size_t length;
+    size_t result;
+    size_t i;
+    uint64_t total;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 11);
+
+    /* Every length, so that each vector path and each of its scalar
+     * tails is covered, with and without padding.
+     */
+
+    for (length = 0; length < sizeof (input); length++)
+    {
+        standard_length = Base64ReferenceEncode(input, length, standard);
+
+        for (i = 0; i < standard_length; i++)
+        {
+            expected[i] = (standard[i] == '+') ? '-' :
+                          (standard[i] == '/') ? '_' : standard[i];
+        }
+
+        result = nl_base64_encode_flags(input, length, output, NLBASE64_FLAG_URL_SAFE);
+        NL_TEST_ASSERT(inSuite, result == standard_length);
+        n = memcmp(output, expected, standard_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        expected_length = nl_base64_encoded_len(length, false);
+
+        result = nl_base64_encode_flags(input, length, output, NLBASE64_FLAG_URL_SAFE | NLBASE64_FLAG_NO_PADDING);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        n = memcmp(output, expected, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        result = nl_base64_encode_flags(input, length, output, NLBASE64_FLAG_NO_PADDING);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        n = memcmp(output, standard, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        /* Either alphabet, padded or not, decodes. */
+
+        result = nl_base64_decode_flags(expected, standard_length, decoded, NLBASE64_FLAG_URL_SAFE);
+        NL_TEST_ASSERT(inSuite, result == length);
+        n = memcmp(decoded, input, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        result = nl_base64_decode_flags(expected, expected_length, decoded, NLBASE64_FLAG_URL_SAFE);
+        NL_TEST_ASSERT(inSuite, result == length);
+        n = memcmp(decoded, input, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        result = nl_base64_decode_flags(standard, standard_length, decoded, NLBASE64_FLAG_URL_SAFE);
+        NL_TEST_ASSERT(inSuite, result == length);
+        n = memcmp(decoded, input, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        /* The standard decoder rejects the URL-safe alphabet. */
+
+        if (memcmp(expected, standard, standard_length) != 0)
+        {
+            result = nl_base64_decode_ex(expected, standard_length, decoded);
+            NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+
+            result = nl_base64_decode_flags(expected, standard_length, decoded, 0);
+            NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+        }
+    }
+
+    /* Mixed alphabets decode in URL-safe mode. */
+
+    result = nl_base64_decode_flags("-_+/", 4, decoded, NLBASE64_FLAG_URL_SAFE);
+    NL_TEST_ASSERT(inSuite, result == 3);
+    NL_TEST_ASSERT(inSuite, decoded[0] == 0xFB && decoded[1] == 0xFF && decoded[2] == 0xBF);
+
+    result = nl_base64_decode_flags("-_+*", 4, decoded, NLBASE64_FLAG_URL_SAFE);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+
+    /* Streaming. */
+
+    standard_length = Base64ReferenceEncode(input, sizeof (input), standard);
+
+    for (i = 0; i < standard_length; i++)
+    {
+        expected[i] = (standard[i] == '+') ? '-' :
+                      (standard[i] == '/') ? '_' : standard[i];
+    }
+
+    putchar_context.output = output;
+
+    nl_base64_stream_enc_ex_start(&enc_state, Base64StreamPutchar, &putchar_context);
+    nl_base64_stream_enc_ex_set_flags(&enc_state, NLBASE64_FLAG_URL_SAFE);
+
+    for (i = 0; i < sizeof (input); i += 7)
+        nl_base64_stream_enc_ex_more(&input[i], (sizeof (input) - i < 7) ? sizeof (input) - i : 7, &enc_state);
+
+    total = nl_base64_stream_enc_ex_finish(false, &enc_state);
+    NL_TEST_ASSERT(inSuite, total == nl_base64_encoded_len(sizeof (input), false));
+    n = memcmp(output, expected, total);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    nl_base64_stream_dec_start(&dec_state, NULL, NULL);
+    nl_base64_stream_dec_set_flags(&dec_state, NLBASE64_FLAG_URL_SAFE);
+
+    for (i = 0, result = 0; i < total; i += 5)
+        result += nl_base64_stream_dec_more(&output[i], (total - i < 5) ? total - i : 5, &decoded[result], &dec_state);
+
+    total = nl_base64_stream_dec_finish(&dec_state);
+    NL_TEST_ASSERT(inSuite, total == sizeof (input));
+    n = memcmp(decoded, input, sizeof (input));
+    NL_TEST_ASSERT(inSuite, n == 0);
+}
+
+static void TestBase64InPlace(nlTestSuite *inSuite, void *inContext)
+{
+    static const uint8_t flags[] = {
+        0,
+        NLBASE64_FLAG_URL_SAFE,
+        NLBASE64_FLAG_NO_PADDING,
+        NLBASE64_FLAG_URL_SAFE | NLBASE64_FLAG_NO_PADDING
+    };
+    static uint8_t input[100003];
+    static uint8_t buffer[((sizeof (input) + 2) / 3) * 4 + 8];
+    static char expected[((sizeof (input) + 2) / 3) * 4];
+    static const size_t large[] = { 4096, 65535, 65536, 65537, sizeof (input) };
+    size_t expected_length;
+    size_t result;
+    size_t i, j, k;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 11);
+
+    /* Every short length, spanning the staged prefix and the first few
+     * chunks encoded in place, for every flag combination. The buffer
+     * is exactly as long as the output, with a guard after it.
+     */
+
+    for (i = 0; i < 1024; i++)
+    {
+        for (j = 0; j < sizeof (flags); j++)
+        {
+            expected_length = nl_base64_encode_flags(input, i, expected, flags[j]);
+
+            memset(buffer, 0xA5, expected_length + 8);
+            memcpy(buffer, input, i);
+
+            result = nl_base64_encode_in_place(buffer, i, flags[j]);
+            NL_TEST_ASSERT(inSuite, result == expected_length);
+            n = memcmp(buffer, expected, expected_length);
+            NL_TEST_ASSERT(inSuite, n == 0);
+
+            for (k = expected_length; k < expected_length + 8; k++)
+                NL_TEST_ASSERT(inSuite, buffer[k] == 0xA5);
+        }
+    }
+
+    for (i = 0; i < sizeof (large) / sizeof (large[0]); i++)
+    {
+        expected_length = nl_base64_encode_ex(input, large[i], expected);
+
+        memcpy(buffer, input, large[i]);
+
+        result = nl_base64_encode_in_place(buffer, large[i], 0);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        n = memcmp(buffer, expected, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+}
+
+static void TestBase64Validate(nlTestSuite *inSuite, void *inContext)
+{
+    static const char corruptions[] = { '=', '*', '-', '_', '+', '/', '\n', ' ', '\0', '\x80', '\xFF', 'A' };
+    static uint8_t input[1000];
+    static char encoded[((sizeof (input) + 2) / 3) * 4 + 8];
+    static uint8_t decoded[sizeof (encoded)];
+    size_t encoded_length;
+    uint32_t seed = 23;
+    size_t i, j, k;
+
+    Base64FillPattern(input, sizeof (input), 19);
+
+    /* Well-formed strings of every length, padded or not, and their
+     * truncations.
+     */
+
+    for (i = 0; i < 300; i++)
+    {
+        encoded_length = nl_base64_encode_ex(input, i, encoded);
+
+        NL_TEST_ASSERT(inSuite, nl_base64_validate(encoded, encoded_length, 0) == i);
+        NL_TEST_ASSERT(inSuite, nl_base64_validate(encoded, encoded_length, NLBASE64_FLAG_URL_SAFE) == i);
+
+        for (j = 0; j <= encoded_length; j++)
+            NL_TEST_ASSERT(inSuite, nl_base64_validate(encoded, j, 0) == nl_base64_decode_ex(encoded, j, decoded));
+    }
+
+    /* Corrupting one or two characters anywhere, in either alphabet,
+     * agrees with the decoder, including padding in the middle, which
+     * ends the input.
+     */
+
+    for (i = 0; i < 4000; i++)
+    {
+        const uint8_t flags = (i & 1) ? NLBASE64_FLAG_URL_SAFE : 0;
+        size_t length;
+
+        seed = seed * 1103515245 + 12345;
+        length = (seed >> 8) % sizeof (input);
+
+        encoded_length = nl_base64_encode_flags(input, length, encoded, (i & 2) ? NLBASE64_FLAG_URL_SAFE : 0);
+
+        for (j = 0; j < 1 + (i & 4) / 4 && encoded_length > 0; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            k = (seed >> 8) % encoded_length;
+            encoded[k] = corruptions[(seed >> 4) % sizeof (corruptions)];
+        }
+
+        NL_TEST_ASSERT(inSuite, nl_base64_validate(encoded, encoded_length, flags) ==
+                       nl_base64_decode_flags(encoded, encoded_length, decoded, flags));
+    }
+}
+
+static void TestBase64Segments(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t input[4099];
+    static char output[((sizeof (input) + 2) / 3) * 4];
+    static char expected[((sizeof (input) + 2) / 3) * 4];
+    nl_base64_segment_t segments[64] = { { 0 } };
+    size_t expected_length;
+    size_t num_segments;
+    size_t offset;
+    size_t result;
+    uint32_t seed = 17;
+    size_t i, j;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 3);
+
+    /* No segments, and every way of splitting a short input in two. */
+
+    result = nl_base64_encode_segments(segments, 0, output, 0);
+    NL_TEST_ASSERT(inSuite, result == 0);
+
+    for (i = 0; i <= 10; i++)
+    {
+        for (j = 0; j <= i; j++)
+        {
+            segments[0].data   = input;
+            segments[0].length = j;
+            segments[1].data   = &input[j];
+            segments[1].length = i - j;
+
+            expected_length = nl_base64_encode_ex(input, i, expected);
+
+            result = nl_base64_encode_segments(segments, 2, output, 0);
+            NL_TEST_ASSERT(inSuite, result == expected_length);
+            n = memcmp(output, expected, expected_length);
+            NL_TEST_ASSERT(inSuite, n == 0);
+        }
+    }
+
+    /* Pseudo-random splits of a longer input, including empty and
+     * single-byte segments, for every flag combination.
+     */
+
+    for (i = 0; i < 200; i++)
+    {
+        const uint8_t flags = i & (NLBASE64_FLAG_URL_SAFE | NLBASE64_FLAG_NO_PADDING);
+
+        for (num_segments = 0, offset = 0; num_segments < 63 && offset < sizeof (input); num_segments++)
+        {
+            size_t length;
+
+            seed = seed * 1103515245 + 12345;
+            length = (seed >> 16) % ((num_segments % 4 == 0) ? 300 : 4);
+
+            if (length > sizeof (input) - offset)
+                length = sizeof (input) - offset;
+
+            segments[num_segments].data   = &input[offset];
+            segments[num_segments].length = length;
+            offset += length;
+        }
+
+        expected_length = nl_base64_encode_flags(input, offset, expected, flags);
+
+        result = nl_base64_encode_segments(segments, num_segments, output, flags);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        n = memcmp(output, expected, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+}
+
+/*
+ * Write function that accumulates decoded bytes into a buffer.
+ */
+struct Base64CrcWriteContext
+{
+    uint8_t *bytes;
+    size_t   length;
+};
+
+static void Base64CrcWrite(const uint8_t *inBytes, size_t inLen, void *inContext)
+{
+    struct Base64CrcWriteContext *context = (struct Base64CrcWriteContext *)inContext;
+
+    memcpy(&context->bytes[context->length], inBytes, inLen);
+    context->length += inLen;
+}
+
+static void TestBase64Crc(nlTestSuite *inSuite, void *inContext)
+{
+    static const nl_base64_crc_update_t updates[] = { nl_crc32, nl_crc32c };
+    static const size_t lengths[] = { 0, 1, 2, 3, 3071, 3072, 3073, 10000, 50001 };
+    static uint8_t input[50001];
+    static char encoded[((sizeof (input) + 2) / 3) * 4];
+    static uint8_t decoded[sizeof (input)];
+    nl_base64_stream_dec_state_t state;
+    struct Base64CrcWriteContext context;
+    size_t encoded_length;
+    size_t result;
+    size_t i, j, k;
+    uint32_t crc;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 13);
+
+    for (i = 0; i < sizeof (lengths) / sizeof (lengths[0]); i++)
+    {
+        encoded_length = nl_base64_encode_ex(input, lengths[i], encoded);
+
+        for (j = 0; j < sizeof (updates) / sizeof (updates[0]); j++)
+        {
+            const uint32_t expected = updates[j](0, input, lengths[i]);
+
+            crc = 0;
+            result = nl_base64_decode_crc(encoded, encoded_length, decoded, 0, updates[j], &crc);
+            NL_TEST_ASSERT(inSuite, result == lengths[i]);
+            NL_TEST_ASSERT(inSuite, crc == expected);
+            n = memcmp(decoded, input, lengths[i]);
+            NL_TEST_ASSERT(inSuite, n == 0);
+
+            /* Streaming, into a buffer in odd-sized fragments and through
+             * a write function.
+             */
+
+            nl_base64_stream_dec_start(&state, NULL, NULL);
+            nl_base64_stream_dec_set_crc(&state, updates[j], 0);
+
+            for (k = 0, result = 0; k < encoded_length; k += 4999)
+                result += nl_base64_stream_dec_more(&encoded[k], (encoded_length - k < 4999) ? encoded_length - k : 4999,
+                                                    &decoded[result], &state);
+
+            NL_TEST_ASSERT(inSuite, nl_base64_stream_dec_finish(&state) == lengths[i]);
+            NL_TEST_ASSERT(inSuite, state.crc == expected);
+
+            context.bytes = decoded;
+            context.length = 0;
+
+            nl_base64_stream_dec_start(&state, Base64CrcWrite, &context);
+            nl_base64_stream_dec_set_crc(&state, updates[j], 0);
+
+            nl_base64_stream_dec_more(encoded, encoded_length, NULL, &state);
+
+            NL_TEST_ASSERT(inSuite, nl_base64_stream_dec_finish(&state) == lengths[i]);
+            NL_TEST_ASSERT(inSuite, state.crc == expected);
+            NL_TEST_ASSERT(inSuite, context.length == lengths[i]);
+        }
+    }
+
+    /* Decoding in place, continuing from an earlier CRC. */
+
+    encoded_length = nl_base64_encode_ex(input, 10000, encoded);
+
+    crc = nl_crc32c(0, "prefix", 6);
+    result = nl_base64_decode_crc(encoded, encoded_length, (uint8_t *)encoded, 0, nl_crc32c, &crc);
+    NL_TEST_ASSERT(inSuite, result == 10000);
+    NL_TEST_ASSERT(inSuite, crc == nl_crc32c(nl_crc32c(0, "prefix", 6), input, 10000));
+    n = memcmp(encoded, input, 10000);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* Padding ends the input, even in the middle, and an error leaves the
+     * CRC untouched.
+     */
+
+    encoded_length = nl_base64_encode_ex(input, 10000, encoded);
+
+    encoded[5000 + 2] = '=';
+    encoded[5000 + 3] = '=';
+
+    encoded[7000] = '*';
+
+    crc = 0;
+    result = nl_base64_decode_crc(encoded, encoded_length, decoded, 0, nl_crc32, &crc);
+    NL_TEST_ASSERT(inSuite, result == 3751);
+    NL_TEST_ASSERT(inSuite, crc == nl_crc32(0, decoded, 3751));
+    n = memcmp(decoded, input, 3750);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    encoded[100] = '*';
+
+    crc = 0x1234;
+    result = nl_base64_decode_crc(encoded, encoded_length, decoded, 0, nl_crc32, &crc);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+    NL_TEST_ASSERT(inSuite, crc == 0x1234);
+}
+
+struct Base64ParallelRunContext
+{
+    size_t calls;
+    size_t tasks;
+};
+
+/*
+ * Run the tasks serially, last to first, so that any dependence on
+ * completion order shows up as a mismatch.
+ */
+static void Base64ParallelRun(nl_base64_parallel_task_t inTask, void *inTaskContext,
+                              size_t inNumTasks, void *inContext)
+{
+    struct Base64ParallelRunContext *context = (struct Base64ParallelRunContext *)inContext;
+
+    context->calls++;
+    context->tasks = inNumTasks;
+
+    while (inNumTasks-- > 0)
+        inTask(inNumTasks, inTaskContext);
+}
+
+static void TestBase64Parallel(nlTestSuite *inSuite, void *inContext)
+{
+    static const size_t tasks[] = { 0, 1, 2, 3, 4, 7, 64, 1000 };
+    static uint8_t input[300001];
+    static char output[((sizeof (input) + 2) / 3) * 4];
+    static char expected[((sizeof (input) + 2) / 3) * 4];
+    static uint8_t decoded[sizeof (input)];
+    struct Base64ParallelRunContext context;
+    size_t expected_length;
+    size_t result;
+    size_t i;
+    int n;
+
+    Base64FillPattern(input, sizeof (input), 5);
+
+    expected_length = nl_base64_encode_ex(input, sizeof (input), expected);
+
+    for (i = 0; i < sizeof (tasks) / sizeof (tasks[0]); i++)
+    {
+        memset(output, 0, sizeof (output));
+
+        result = nl_base64_encode_parallel(input, sizeof (input), output, tasks[i], NULL, NULL);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        n = memcmp(output, expected, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        memset(decoded, 0, sizeof (decoded));
+
+        result = nl_base64_decode_parallel(output, expected_length, decoded, tasks[i], NULL, NULL);
+        NL_TEST_ASSERT(inSuite, result == sizeof (input));
+        n = memcmp(decoded, input, sizeof (input));
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+
+    /* Every length near a chunk boundary, through a caller-supplied run
+     * function.
+     */
+
+    for (i = 3 * 16384 * 2 - 4; i <= 3 * 16384 * 2 + 4; i++)
+    {
+        context.calls = 0;
+
+        memset(output, 0, sizeof (output));
+
+        result = nl_base64_encode_parallel(input, i, output, 2, Base64ParallelRun, &context);
+        NL_TEST_ASSERT(inSuite, result == nl_base64_encode_ex(input, i, expected));
+        n = memcmp(output, expected, result);
+        NL_TEST_ASSERT(inSuite, n == 0);
+        NL_TEST_ASSERT(inSuite, context.calls == 1 && context.tasks == 2);
+
+        memset(decoded, 0, sizeof (decoded));
+
+        result = nl_base64_decode_parallel(output, result, decoded, 2, Base64ParallelRun, &context);
+        NL_TEST_ASSERT(inSuite, result == i);
+        n = memcmp(decoded, input, i);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+
+    /* Small buffers are coded on the calling thread. */
+
+    context.calls = 0;
+
+    result = nl_base64_encode_parallel(input, 1000, output, 4, Base64ParallelRun, &context);
+    NL_TEST_ASSERT(inSuite, result == nl_base64_encoded_len(1000, true));
+    NL_TEST_ASSERT(inSuite, context.calls == 0);
+
+    /* An invalid character in any chunk fails the whole decode, but
+     * anything after padding is ignored, just as in the block decoder.
+     */
+
+    nl_base64_encode_ex(input, sizeof (input), output);
+
+    output[expected_length - 10] = '*';
+
+    result = nl_base64_decode_parallel(output, expected_length, decoded, 4, NULL, NULL);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+    NL_TEST_ASSERT(inSuite, nl_base64_decode_ex(output, expected_length, decoded) == SIZE_MAX);
+
+    i = (expected_length / 4) & ~(size_t)3;
+
+    output[i + 2] = '=';
+    output[i + 3] = '=';
+
+    result = nl_base64_decode_parallel(output, expected_length, decoded, 4, NULL, NULL);
+    NL_TEST_ASSERT(inSuite, result == nl_base64_decode_ex(output, expected_length, decoded));
+    NL_TEST_ASSERT(inSuite, result == i / 4 * 3 + 1);
+
+    output[10] = '*';
+
+    result = nl_base64_decode_parallel(output, expected_length, decoded, 4, NULL, NULL);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+}
+
 static const nlTest sTests[] = {
     NL_TEST_DEF("base64 block encoding",  TestBase64BlockEncoding),
+    NL_TEST_DEF("base64 block encoding lengths", TestBase64BlockEncodingLengths),
     NL_TEST_DEF("base64 block decoding",  TestBase64BlockDecoding),
+    NL_TEST_DEF("base64 block decoding lengths", TestBase64BlockDecodingLengths),
+    NL_TEST_DEF("base64 block alphabet",  TestBase64BlockAlphabet),
+    NL_TEST_DEF("base64 block large",     TestBase64BlockLarge),
+    NL_TEST_DEF("base64 lengths",         TestBase64Lengths),
     NL_TEST_DEF("base64 stream encoding", TestBase64StreamEncoding),
+    NL_TEST_DEF("base64 stream encoding fragments", TestBase64StreamEncodingFragments),
+    NL_TEST_DEF("base64 stream encoding buffered", TestBase64StreamEncodingBuffered),
+    NL_TEST_DEF("base64 stream decoding", TestBase64StreamDecoding),
+    NL_TEST_DEF("base64 whitespace decoding", TestBase64WhitespaceDecoding),
+    NL_TEST_DEF("base64 line encoding",   TestBase64LineEncoding),
+    NL_TEST_DEF("base64 url-safe alphabet", TestBase64UrlSafe),
+    NL_TEST_DEF("base64 in-place encoding", TestBase64InPlace),
+    NL_TEST_DEF("base64 validation",      TestBase64Validate),
+    NL_TEST_DEF("base64 segment encoding", TestBase64Segments),
+    NL_TEST_DEF("base64 crc decoding",    TestBase64Crc),
+    NL_TEST_DEF("base64 parallel",        TestBase64Parallel),
     NL_TEST_SENTINEL()
 };
 
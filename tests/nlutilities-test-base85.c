@@ -0,0 +1,331 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a unit test for the Nest Labs Utilities
+ *      Ascii85 (base85) interfaces.
+ *
+ */
+
+#include <nlbase85.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <nlunit-test.h>
+
+struct Base85TestVector
+{
+    const char *decoded;
+    size_t      decoded_length;
+    const char *encoded;
+    uint8_t     flags;
+};
+
+static const struct Base85TestVector sBase85Vectors[] = {
+    { "",                  0, "",        0                         },
+    { "M",                 1, "9`",      0                         },
+    { "Ma",                2, "9jn",     0                         },
+    { "Man",               3, "9jqo",    0                         },
+    { "Man ",              4, "9jqo^",   0                         },
+    { "Man i",             5, "9jqo^B`", 0                         },
+    { "sure.",             5, "F*2M7/c", 0                         },
+    { "\xff\xff\xff\xff",  4, "s8W-!",   0                         },
+    { "\xff",              1, "rr",      0                         },
+    { "\0\0\0",            3, "!!!!",    NLBASE85_FLAG_ZERO_GROUPS },
+    { "\0\0\0\0",          4, "!!!!!",   0                         },
+    { "\0\0\0\0",          4, "z",       NLBASE85_FLAG_ZERO_GROUPS },
+    { "\0\0\0\0\0",        5, "z!!",     NLBASE85_FLAG_ZERO_GROUPS },
+};
+
+/*
+ * Fill a buffer with a deterministic, pseudo-random byte pattern with
+ * runs of zero groups mixed in.
+ */
+static void Base85FillPattern(uint8_t *outData, size_t inSize, uint32_t inSeed)
+{
+    size_t i;
+
+    for (i = 0; i < inSize; i++)
+    {
+        inSeed = inSeed * 1103515245 + 12345;
+        outData[i] = ((i / 4) % 7 == 3) ? 0 : (uint8_t)(inSeed >> 16);
+    }
+}
+
+static void TestBase85BlockVectors(nlTestSuite *inSuite, void *inContext)
+{
+    char encoded[16];
+    uint8_t decoded[16];
+    size_t length;
+    size_t i;
+    int n;
+
+    for (i = 0; i < sizeof (sBase85Vectors) / sizeof (sBase85Vectors[0]); i++)
+    {
+        const struct Base85TestVector *vector = &sBase85Vectors[i];
+        const size_t encoded_length = strlen(vector->encoded);
+
+        length = nl_base85_encode((const uint8_t *)vector->decoded, vector->decoded_length, encoded, vector->flags);
+        NL_TEST_ASSERT(inSuite, length == encoded_length);
+        NL_TEST_ASSERT(inSuite, length <= nl_base85_encoded_len(vector->decoded_length));
+        n = memcmp(encoded, vector->encoded, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        length = nl_base85_decode(vector->encoded, encoded_length, decoded);
+        NL_TEST_ASSERT(inSuite, length == vector->decoded_length);
+        NL_TEST_ASSERT(inSuite, length == nl_base85_decoded_len(vector->encoded, encoded_length));
+        n = memcmp(decoded, vector->decoded, length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+}
+
+static void TestBase85BlockLarge(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t input[4099];
+    static char encoded[(sizeof (input) + 3) / 4 * 5];
+    static uint8_t decoded[sizeof (input)];
+    uint8_t flags;
+    size_t length;
+    size_t size;
+    int n;
+
+    Base85FillPattern(input, sizeof (input), 3);
+
+    for (flags = 0; flags <= NLBASE85_FLAG_ZERO_GROUPS; flags++)
+    {
+        for (size = sizeof (input) - 11; size <= sizeof (input); size++)
+        {
+            length = nl_base85_encode(input, size, encoded, flags);
+            NL_TEST_ASSERT(inSuite, (flags == 0) ? length == nl_base85_encoded_len(size) :
+                                                   length < nl_base85_encoded_len(size));
+
+            NL_TEST_ASSERT(inSuite, nl_base85_decoded_len(encoded, length) == size);
+
+            length = nl_base85_decode(encoded, length, decoded);
+            NL_TEST_ASSERT(inSuite, length == size);
+            n = memcmp(decoded, input, size);
+            NL_TEST_ASSERT(inSuite, n == 0);
+        }
+    }
+}
+
+static void TestBase85BlockErrors(nlTestSuite *inSuite, void *inContext)
+{
+    static const char * const invalid[] = {
+        "9",                    /* a lone character */
+        "9jqo^9",               /* as does 1 after a whole group */
+        "s8W-\"",               /* a group above 0xFFFFFFFF */
+        "uuuuu",
+        "uu",                   /* a partial group above it */
+        "9jqo^Bv",              /* 'v' is not in the alphabet */
+        "9jz",                  /* 'z' within a group */
+        "9jqo^z9jqz^",
+        "9j o^",                /* whitespace */
+        "<~9jqo^~>",            /* delimiters */
+    };
+    uint8_t decoded[16];
+    size_t length;
+    size_t i;
+
+    for (i = 0; i < sizeof (invalid) / sizeof (invalid[0]); i++)
+    {
+        length = nl_base85_decode(invalid[i], strlen(invalid[i]), decoded);
+        NL_TEST_ASSERT(inSuite, length == SIZE_MAX);
+    }
+}
+
+struct Base85StreamEncodeWriteContext
+{
+    char   *output;
+    size_t  calls;
+};
+
+static void Base85StreamEncodeWrite(const char *inChars, size_t inLen, void *inContext)
+{
+    struct Base85StreamEncodeWriteContext *context = (struct Base85StreamEncodeWriteContext *)(inContext);
+
+    memcpy(context->output, inChars, inLen);
+    context->output += inLen;
+    context->calls++;
+}
+
+static void TestBase85StreamEncoding(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t input[10001];
+    static char output[(sizeof (input) + 3) / 4 * 5];
+    static char expected[(sizeof (input) + 3) / 4 * 5];
+    struct Base85StreamEncodeWriteContext context;
+    nl_base85_stream_enc_state_t state;
+    size_t expected_length;
+    size_t offset;
+    size_t fragment;
+    uint8_t flags;
+    uint64_t written;
+    uint64_t result;
+    int n;
+
+    Base85FillPattern(input, sizeof (input), 6);
+
+    for (flags = 0; flags <= NLBASE85_FLAG_ZERO_GROUPS; flags++)
+    {
+        expected_length = nl_base85_encode(input, sizeof (input), expected, flags);
+
+        context.output = output;
+        context.calls  = 0;
+        written        = 0;
+
+        nl_base85_stream_enc_start(&state, flags, Base85StreamEncodeWrite, &context);
+
+        for (offset = 0, fragment = 1; offset < sizeof (input); offset += fragment, fragment = (fragment % 97) + 1)
+        {
+            if (fragment > sizeof (input) - offset)
+                fragment = sizeof (input) - offset;
+
+            written += nl_base85_stream_enc_more(&input[offset], fragment, &state);
+            NL_TEST_ASSERT(inSuite, written == (uint64_t)(context.output - output));
+        }
+
+        result = nl_base85_stream_enc_finish(&state);
+        NL_TEST_ASSERT(inSuite, result == expected_length);
+        NL_TEST_ASSERT(inSuite, (size_t)(context.output - output) == expected_length);
+        n = memcmp(output, expected, expected_length);
+        NL_TEST_ASSERT(inSuite, n == 0);
+    }
+}
+
+struct Base85StreamWriteContext
+{
+    uint8_t *output;
+    size_t   calls;
+};
+
+static void Base85StreamWrite(const uint8_t *inBytes, size_t inLen, void *inContext)
+{
+    struct Base85StreamWriteContext *context = (struct Base85StreamWriteContext *)(inContext);
+
+    memcpy(context->output, inBytes, inLen);
+    context->output += inLen;
+    context->calls++;
+}
+
+static void TestBase85StreamDecoding(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t expected[20003];
+    static char input[(sizeof (expected) + 3) / 4 * 5];
+    static uint8_t output[sizeof (expected) + 4];
+    struct Base85StreamWriteContext context;
+    nl_base85_stream_dec_state_t state;
+    size_t input_length;
+    size_t offset;
+    size_t fragment;
+    size_t result;
+    size_t total;
+    uint64_t finish;
+    int n;
+
+    Base85FillPattern(expected, sizeof (expected), 9);
+    input_length = nl_base85_encode(expected, sizeof (expected), input, NLBASE85_FLAG_ZERO_GROUPS);
+
+    /* Fragments of every size from 1 to 97 characters, into a buffer... */
+
+    nl_base85_stream_dec_start(&state, NULL, NULL);
+
+    for (offset = 0, fragment = 1, total = 0; offset < input_length; offset += fragment, fragment = (fragment % 97) + 1)
+    {
+        if (fragment > input_length - offset)
+            fragment = input_length - offset;
+
+        result = nl_base85_stream_dec_more(&input[offset], fragment, &output[total], &state);
+        NL_TEST_ASSERT(inSuite, result != SIZE_MAX);
+        total += result;
+    }
+
+    finish = nl_base85_stream_dec_finish(&output[total], &state);
+    NL_TEST_ASSERT(inSuite, finish == sizeof (expected));
+    n = memcmp(output, expected, sizeof (expected));
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* ...and to a write function. */
+
+    memset(output, 0, sizeof (output));
+    context.output = output;
+    context.calls  = 0;
+
+    nl_base85_stream_dec_start(&state, Base85StreamWrite, &context);
+
+    for (offset = 0, fragment = 1; offset < input_length; offset += fragment, fragment = (fragment % 1013) + 1)
+    {
+        if (fragment > input_length - offset)
+            fragment = input_length - offset;
+
+        result = nl_base85_stream_dec_more(&input[offset], fragment, NULL, &state);
+        NL_TEST_ASSERT(inSuite, result != SIZE_MAX);
+    }
+
+    finish = nl_base85_stream_dec_finish(NULL, &state);
+    NL_TEST_ASSERT(inSuite, finish == sizeof (expected));
+    NL_TEST_ASSERT(inSuite, (size_t)(context.output - output) == sizeof (expected));
+    n = memcmp(output, expected, sizeof (expected));
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* A lone final character and an overflowing partial group are
+     * reported by finish, and other errors as soon as they are seen.
+     */
+
+    nl_base85_stream_dec_start(&state, NULL, NULL);
+    result = nl_base85_stream_dec_more("9jqo^9", 6, output, &state);
+    NL_TEST_ASSERT(inSuite, result == 4);
+    NL_TEST_ASSERT(inSuite, nl_base85_stream_dec_finish(output, &state) == UINT64_MAX);
+
+    nl_base85_stream_dec_start(&state, NULL, NULL);
+    result = nl_base85_stream_dec_more("uu", 2, output, &state);
+    NL_TEST_ASSERT(inSuite, result == 0);
+    NL_TEST_ASSERT(inSuite, nl_base85_stream_dec_finish(output, &state) == UINT64_MAX);
+
+    nl_base85_stream_dec_start(&state, NULL, NULL);
+    result = nl_base85_stream_dec_more("s8W", 3, output, &state);
+    NL_TEST_ASSERT(inSuite, result == 0);
+    result = nl_base85_stream_dec_more("-\"", 2, output, &state);
+    NL_TEST_ASSERT(inSuite, result == SIZE_MAX);
+    NL_TEST_ASSERT(inSuite, nl_base85_stream_dec_finish(output, &state) == UINT64_MAX);
+}
+
+static const nlTest sTests[] = {
+    NL_TEST_DEF("base85 block vectors",   TestBase85BlockVectors),
+    NL_TEST_DEF("base85 block large",     TestBase85BlockLarge),
+    NL_TEST_DEF("base85 block errors",    TestBase85BlockErrors),
+    NL_TEST_DEF("base85 stream encoding", TestBase85StreamEncoding),
+    NL_TEST_DEF("base85 stream decoding", TestBase85StreamDecoding),
+    NL_TEST_SENTINEL()
+};
+
+int main(void)
+{
+    nlTestSuite theSuite = {
+        "nlutilities-base85",
+        &sTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    nlTestRunner(&theSuite, NULL);
+
+    return nlTestRunnerStats(&theSuite);
+}
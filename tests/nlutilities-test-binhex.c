@@ -25,16 +25,265 @@
 
 #include <nlutilities.h>
 
+#include <string.h>
+
 #include <nlunit-test.h>
 
+/*
+ * Straightforward, one digit at a time reference converter against
+ * which the optimized one is checked.
+ */
+static void BinToHexReference(char *outHex, const uint8_t *inData, size_t inSize, char inSep)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    size_t i;
+
+    for (i = 0; i < inSize; i++)
+    {
+        *outHex++ = digits[inData[i] >> 4];
+        *outHex++ = digits[inData[i] & 0xf];
+
+        if (inSep && (i % 2) == 1 && i + 1 < inSize)
+            *outHex++ = inSep;
+    }
+
+    *outHex = '\0';
+}
+
+static void TestBinToHexStr(nlTestSuite *inSuite, void *inContext)
+{
+    static const uint8_t bin[] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0x00 };
+    char hex[sizeof (bin) * 3];
+    char *result;
+    int n;
+
+    result = nl_bintohexstr(hex, bin, sizeof (bin), '\0');
+    NL_TEST_ASSERT(inSuite, result == hex);
+    n = strcmp(hex, "0123456789ABCDEF00");
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    nl_bintohexstr(hex, bin, sizeof (bin), ':');
+    n = strcmp(hex, "0123:4567:89AB:CDEF:00");
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    nl_bintohexstr(hex, bin, 8, '-');
+    n = strcmp(hex, "0123-4567-89AB-CDEF");
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    nl_bintohexstr(hex, bin, 0, ':');
+    NL_TEST_ASSERT(inSuite, hex[0] == '\0');
+}
+
+static void TestBinToHexStrLengths(nlTestSuite *inSuite, void *inContext)
+{
+    static const char seps[] = { '\0', ':', ' ' };
+    static uint8_t bin[300];
+    static char expected[sizeof (bin) * 3];
+    static char hex[sizeof (bin) * 3 + 1];
+    size_t offset;
+    size_t size;
+    size_t i;
+    int n;
+
+    for (i = 0; i < sizeof (bin); i++)
+        bin[i] = (uint8_t)(i * 97 + 13);
+
+    /* Every length across several whole vector blocks, from both even
+     * and odd alignments, with and without separators.
+     */
+
+    for (i = 0; i < sizeof (seps); i++)
+    {
+        for (offset = 0; offset < 2; offset++)
+        {
+            for (size = 0; size <= sizeof (bin) - offset; size++)
+            {
+                BinToHexReference(expected, &bin[offset], size, seps[i]);
+
+                memset(hex, 0x55, sizeof (hex));
+                nl_bintohexstr(hex, &bin[offset], size, seps[i]);
+
+                n = strcmp(hex, expected);
+                NL_TEST_ASSERT(inSuite, n == 0);
+
+                /* Nothing is written past the terminator. */
+
+                NL_TEST_ASSERT(inSuite, hex[strlen(expected) + 1] == 0x55);
+            }
+        }
+    }
+}
+
+static void BinToHexGroupedReference(char *outHex, const uint8_t *inData, size_t inSize, size_t inGroup, const char *inSep, bool inLower)
+{
+    const char *digits = inLower ? "0123456789abcdef" : "0123456789ABCDEF";
+    size_t i;
+
+    for (i = 0; i < inSize; i++)
+    {
+        if (i > 0 && inGroup > 0 && (i % inGroup) == 0)
+        {
+            strcpy(outHex, inSep);
+            outHex += strlen(inSep);
+        }
+
+        *outHex++ = digits[inData[i] >> 4];
+        *outHex++ = digits[inData[i] & 0xf];
+    }
+
+    *outHex = '\0';
+}
+
+static void TestBinToHexStrGrouped(nlTestSuite *inSuite, void *inContext)
+{
+    static const uint8_t mac[] = { 0x00, 0x1a, 0x2b, 0xc3, 0xd4, 0xef };
+    static const size_t groups[] = { 1, 2, 3, 4, 8, 16 };
+    static const char *seps[] = { ":", "-", ", ", " :: " };
+    static uint8_t bin[100];
+    static char expected[sizeof (bin) * 6];
+    static char hex[sizeof (bin) * 6];
+    size_t size;
+    size_t i, j, k;
+    int n;
+
+    nl_bintohexstr_grouped(hex, mac, sizeof (mac), 1, ":", NLBINTOHEX_FLAG_LOWER_CASE);
+    n = strcmp(hex, "00:1a:2b:c3:d4:ef");
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    nl_bintohexstr_grouped(hex, mac, sizeof (mac), 4, " ", 0);
+    n = strcmp(hex, "001A2BC3 D4EF");
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    nl_bintohexstr_grouped(hex, mac, sizeof (mac), 1, NULL, NLBINTOHEX_FLAG_LOWER_CASE);
+    n = strcmp(hex, "001a2bc3d4ef");
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    for (i = 0; i < sizeof (bin); i++)
+        bin[i] = (uint8_t)(i * 97 + 13);
+
+    for (i = 0; i < sizeof (groups) / sizeof (groups[0]); i++)
+    {
+        for (j = 0; j < sizeof (seps) / sizeof (seps[0]); j++)
+        {
+            for (k = 0; k < 2; k++)
+            {
+                for (size = 0; size <= sizeof (bin); size++)
+                {
+                    BinToHexGroupedReference(expected, bin, size, groups[i], seps[j], k);
+
+                    nl_bintohexstr_grouped(hex, bin, size, groups[i], seps[j], k ? NLBINTOHEX_FLAG_LOWER_CASE : 0);
+
+                    n = strcmp(hex, expected);
+                    NL_TEST_ASSERT(inSuite, n == 0);
+                    NL_TEST_ASSERT(inSuite, nl_bintohexstr_grouped_len(size, groups[i], strlen(seps[j])) == strlen(expected));
+                }
+            }
+        }
+    }
+}
+
+static void TestStrHexToBinChecked(nlTestSuite *inSuite, void *inContext)
+{
+    static uint8_t bin[300];
+    static char hex[sizeof (bin) * 2 + 1];
+    static uint8_t out[sizeof (bin)];
+    size_t offset;
+    size_t size;
+    size_t result;
+    size_t i;
+    int n;
+
+    for (i = 0; i < sizeof (bin); i++)
+        bin[i] = (uint8_t)(i * 97 + 13);
+
+    nl_bintohexstr(hex, bin, sizeof (bin), '\0');
+
+    /* Lower-case digits decode as well. */
+
+    for (i = 0; i < sizeof (hex); i += 3)
+        if (hex[i] >= 'A' && hex[i] <= 'F')
+            hex[i] += 'a' - 'A';
+
+    for (offset = 0; offset < 2; offset++)
+    {
+        for (size = 0; size <= sizeof (bin) - offset; size++)
+        {
+            memset(out, 0, sizeof (out));
+
+            result = nl_strhextobin_checked(out, &hex[offset * 2], size);
+            NL_TEST_ASSERT(inSuite, result == size * 2);
+
+            n = memcmp(out, &bin[offset], size);
+            NL_TEST_ASSERT(inSuite, n == 0);
+            NL_TEST_ASSERT(inSuite, size == sizeof (out) || out[size] == 0);
+        }
+    }
+
+    /* The first invalid character, wherever it is, is reported, with
+     * everything before it decoded.
+     */
+
+    for (i = 0; i < 200; i++)
+    {
+        static const char invalid[] = { 'g', 'G', '/', ':', '@', '`', ' ', '\0', (char)0x80, (char)0xb0 };
+        const char saved = hex[i];
+
+        hex[i] = invalid[i % sizeof (invalid)];
+
+        result = nl_strhextobin_checked(out, hex, 100);
+        NL_TEST_ASSERT(inSuite, result == i);
+
+        n = memcmp(out, bin, i / 2);
+        NL_TEST_ASSERT(inSuite, n == 0);
+
+        hex[i] = saved;
+    }
+
+    /* In place. */
+
+    result = nl_strhextobin_checked((uint8_t *)hex, hex, sizeof (bin));
+    NL_TEST_ASSERT(inSuite, result == sizeof (bin) * 2);
+
+    n = memcmp(hex, bin, sizeof (bin));
+    NL_TEST_ASSERT(inSuite, n == 0);
+}
+
+static void TestStrHexToBinInvalid(nlTestSuite *inSuite, void *inContext)
+{
+    char hex[130];
+    uint8_t out[sizeof (hex) / 2];
+    uint8_t expected;
+    size_t i;
+
+    memset(hex, 'a', sizeof (hex));
+    hex[70] = 'x';
+
+    /* nl_strhextobin still decodes past invalid characters, as
+     * nl_hextobin does.
+     */
+
+    nl_strhextobin(out, hex, sizeof (out));
+
+    for (i = 0; i < sizeof (out); i++)
+    {
+        expected = (uint8_t)(nl_hextobin(hex[i * 2 + 0]) << 4 | nl_hextobin(hex[i * 2 + 1]));
+        NL_TEST_ASSERT(inSuite, out[i] == expected);
+    }
+}
+
 static const nlTest sTests[] = {
+    NL_TEST_DEF("binary to hexadecimal",         TestBinToHexStr),
+    NL_TEST_DEF("binary to hexadecimal lengths", TestBinToHexStrLengths),
+    NL_TEST_DEF("grouped binary to hexadecimal", TestBinToHexStrGrouped),
+    NL_TEST_DEF("checked hexadecimal to binary", TestStrHexToBinChecked),
+    NL_TEST_DEF("invalid hexadecimal to binary", TestStrHexToBinInvalid),
     NL_TEST_SENTINEL()
 };
 
 int main(void)
 {
     nlTestSuite theSuite = {
-        "TBD",
+        "nlutilities-binhex",
         &sTests[0]
     };
 
@@ -0,0 +1,140 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a unit test for the Nest Labs Utilities
+ *      CRC-32 and CRC-32C interfaces.
+ *
+ */
+
+#include <nlcrc32.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <nlunit-test.h>
+
+/*
+ * Straightforward, one bit at a time reference CRC against which the
+ * optimized implementations are checked.
+ */
+static uint32_t ReferenceCrc(uint32_t inPolynomial, uint32_t inCrc, const uint8_t *inData, size_t inSize)
+{
+    size_t i;
+    int bit;
+
+    inCrc = ~inCrc;
+
+    for (i = 0; i < inSize; i++)
+    {
+        inCrc ^= inData[i];
+
+        for (bit = 0; bit < 8; bit++)
+            inCrc = (inCrc >> 1) ^ ((inCrc & 1) ? inPolynomial : 0);
+    }
+
+    return ~inCrc;
+}
+
+static void TestCrc32CheckValues(nlTestSuite *inSuite, void *inContext)
+{
+    static const char check[] = "123456789";
+
+    NL_TEST_ASSERT(inSuite, nl_crc32(0, check, 9) == 0xCBF43926);
+    NL_TEST_ASSERT(inSuite, nl_crc32c(0, check, 9) == 0xE3069283);
+
+    NL_TEST_ASSERT(inSuite, nl_crc32(0, check, 0) == 0);
+    NL_TEST_ASSERT(inSuite, nl_crc32c(0, check, 0) == 0);
+}
+
+static void TestCrc32Reference(nlTestSuite *inSuite, void *inContext)
+{
+    uint8_t data[1024 + 8];
+    uint32_t seed = 1;
+    size_t offset;
+    size_t length;
+    size_t i;
+
+    for (i = 0; i < sizeof (data); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+
+    /* Every alignment and every length around the 8-byte blocks. */
+
+    for (offset = 0; offset < 8; offset++)
+    {
+        for (length = 0; length <= 64; length++)
+        {
+            NL_TEST_ASSERT(inSuite, nl_crc32(0, &data[offset], length) ==
+                           ReferenceCrc(0xEDB88320, 0, &data[offset], length));
+            NL_TEST_ASSERT(inSuite, nl_crc32c(0, &data[offset], length) ==
+                           ReferenceCrc(0x82F63B78, 0, &data[offset], length));
+        }
+    }
+
+    NL_TEST_ASSERT(inSuite, nl_crc32(0, data, sizeof (data)) ==
+                   ReferenceCrc(0xEDB88320, 0, data, sizeof (data)));
+    NL_TEST_ASSERT(inSuite, nl_crc32c(0, data, sizeof (data)) ==
+                   ReferenceCrc(0x82F63B78, 0, data, sizeof (data)));
+}
+
+static void TestCrc32Incremental(nlTestSuite *inSuite, void *inContext)
+{
+    uint8_t data[300];
+    uint32_t crc;
+    uint32_t crcc;
+    size_t split;
+
+    for (split = 0; split < sizeof (data); split++)
+        data[split] = (uint8_t)(split * 7 + 3);
+
+    /* Continuing from the CRC of a prefix gives the CRC of the whole. */
+
+    for (split = 0; split <= sizeof (data); split++)
+    {
+        crc = nl_crc32(nl_crc32(0, data, split), &data[split], sizeof (data) - split);
+        NL_TEST_ASSERT(inSuite, crc == nl_crc32(0, data, sizeof (data)));
+
+        crcc = nl_crc32c(nl_crc32c(0, data, split), &data[split], sizeof (data) - split);
+        NL_TEST_ASSERT(inSuite, crcc == nl_crc32c(0, data, sizeof (data)));
+    }
+}
+
+static const nlTest sTests[] = {
+    NL_TEST_DEF("crc32 check values", TestCrc32CheckValues),
+    NL_TEST_DEF("crc32 reference",    TestCrc32Reference),
+    NL_TEST_DEF("crc32 incremental",  TestCrc32Incremental),
+    NL_TEST_SENTINEL()
+};
+
+int main(void)
+{
+    nlTestSuite theSuite = {
+        "nlutilities-crc32",
+        &sTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    nlTestRunner(&theSuite, NULL);
+
+    return nlTestRunnerStats(&theSuite);
+}
@@ -0,0 +1,158 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a unit test for the Nest Labs Utilities
+ *      C++ compile-time base64 and hexadecimal literals.
+ *
+ */
+
+#include <nlliterals.hpp>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <nlbase64.h>
+#include <nlutilities.h>
+
+#include <nlunit-test.h>
+
+#if __cplusplus >= 201402L
+
+/*
+ * Every result below is a constant expression, so the checks that can
+ * be made at compile time are.
+ */
+
+static constexpr auto sHello     = NL_BASE64_LITERAL("SGVsbG8sIHdvcmxkIQ==");
+static constexpr auto sOne       = NL_BASE64_LITERAL("QQ");
+static constexpr auto sTwo       = NL_BASE64_LITERAL("QUI=");
+static constexpr auto sUrlSafe   = NL_BASE64_LITERAL("-_-_");
+static constexpr auto sEmpty     = NL_BASE64_LITERAL("");
+static constexpr auto sHex       = NL_HEX_LITERAL("00ff10aB7f");
+
+static_assert(sHello.size() == 13 && sHello[0] == 'H' && sHello[12] == '!', "base64 literal");
+static_assert(sOne.size() == 1 && sOne[0] == 'A', "base64 literal, one byte, unpadded");
+static_assert(sTwo.size() == 2 && sTwo[0] == 'A' && sTwo[1] == 'B', "base64 literal, two bytes");
+static_assert(sUrlSafe.size() == 3 && sUrlSafe[0] == 0xFB && sUrlSafe[2] == 0xBF, "URL-safe literal");
+static_assert(sEmpty.size() == 0, "empty base64 literal");
+static_assert(sHex.size() == 5 && sHex[0] == 0x00 && sHex[1] == 0xFF && sHex[3] == 0xAB, "hex literal");
+
+static_assert(nl::base64_decoded_length("QUJD") == 3, "decoded length");
+static_assert(nl::base64_decoded_length("QUJDRA==") == 4, "decoded length");
+static_assert(nl::hex_decoded_length("") == 0 && nl::hex_decoded_length("aB09") == 2, "decoded length");
+
+/*
+ * Malformed literals, which NL_BASE64_LITERAL and NL_HEX_LITERAL refuse
+ * to compile.
+ */
+static_assert(nl::base64_literal_valid("QQ==") && nl::base64_literal_valid("QUI=") &&
+              nl::base64_literal_valid("QUJD") && nl::base64_literal_valid("QQ"), "well-formed padding");
+static_assert(!nl::base64_literal_valid("AAAA====") && !nl::base64_literal_valid("QQ======") &&
+              !nl::base64_literal_valid("QQ=") && !nl::base64_literal_valid("QUI==") &&
+              !nl::base64_literal_valid("Q==="), "excess or partial padding");
+static_assert(!nl::base64_literal_valid("QU!D") && !nl::base64_literal_valid("QUJDR") &&
+              !nl::base64_literal_valid("QU=D"), "invalid characters or length");
+static_assert(!nl::hex_literal_valid("zz") && !nl::hex_literal_valid("0g") && !nl::hex_literal_valid("abc"),
+              "invalid hexadecimal literal");
+static constexpr auto sHexBase64 = nl::base64_encode(sHex);
+static constexpr auto sHexHex    = nl::hex_encode(sHex);
+
+static_assert(sHexBase64[7] == '=' && sHexBase64.size() == 9, "base64 encoding");
+static_assert(sHexHex[2] == 'F' && sHexHex[10] == '\0', "hex encoding");
+
+/*
+ * A fixed, pseudo-random test vector long enough to cover every group
+ * position and every 6-bit value.
+ */
+static constexpr auto sVector = NL_HEX_LITERAL(
+    "6f1ee3b2a7c9d4e80531f62a9b0c7d4e5f60718293a4b5c6d7e8f90a1b2c3d4e"
+    "fa0b1c2d3e4f5061728394a5b6c7d8e9f0fedcba98765432100123456789abcd"
+    "ef");
+
+static void TestBase64Literals(nlTestSuite *inSuite, void *inContext)
+{
+    static constexpr auto encoded = nl::base64_encode(sVector);
+    static constexpr auto text = nl::base64_encode("Hello, world!");
+    char expected[sizeof (encoded)];
+    uint8_t decoded[sVector.size()];
+    size_t length;
+    int n;
+
+    /* Compile-time encoding matches the block encoder... */
+
+    length = nl_base64_encode_ex(sVector.data(), sVector.size(), expected);
+    expected[length] = '\0';
+    NL_TEST_ASSERT(inSuite, length + 1 == encoded.size());
+    n = strcmp(encoded.data(), expected);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    n = strcmp(text.data(), "SGVsbG8sIHdvcmxkIQ==");
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    /* ...and compile-time decoding matches the block decoder. */
+
+    length = nl_base64_decode_ex(encoded.data(), encoded.size() - 1, decoded);
+    NL_TEST_ASSERT(inSuite, length == sVector.size());
+    n = memcmp(decoded, sVector.data(), sVector.size());
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    n = memcmp(sHello.data(), "Hello, world!", sHello.size());
+    NL_TEST_ASSERT(inSuite, n == 0);
+}
+
+static void TestHexLiterals(nlTestSuite *inSuite, void *inContext)
+{
+    static constexpr auto encoded = nl::hex_encode(sVector);
+    char expected[sizeof (encoded)];
+    uint8_t decoded[sVector.size()];
+    int n;
+
+    nl_bintohexstr(expected, sVector.data(), sVector.size(), 0);
+    n = strcmp(encoded.data(), expected);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    nl_strhextobin(decoded, encoded.data(), sVector.size());
+    n = memcmp(decoded, sVector.data(), sVector.size());
+    NL_TEST_ASSERT(inSuite, n == 0);
+}
+
+#endif // __cplusplus >= 201402L
+
+static const nlTest sTests[] = {
+#if __cplusplus >= 201402L
+    NL_TEST_DEF("base64 literals", TestBase64Literals),
+    NL_TEST_DEF("hex literals",    TestHexLiterals),
+#endif
+    NL_TEST_SENTINEL()
+};
+
+int main(void)
+{
+    nlTestSuite theSuite = {
+        "nlutilities-literals",
+        &sTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    nlTestRunner(&theSuite, NULL);
+
+    return nlTestRunnerStats(&theSuite);
+}
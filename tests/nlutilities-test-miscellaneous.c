@@ -25,6 +25,11 @@
 
 #include <nlutilities.h>
 
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <nlunit-test.h>
@@ -107,6 +112,129 @@ static void TestGetCharSeparatedBytes(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, bytes[0] == 0x18);
     NL_TEST_ASSERT(inSuite, bytes[1] == 0xb4);
     NL_TEST_ASSERT(inSuite, bytes[2] == 0x30);
+
+    // good. anything strtoul accepts, prefixes, signs and leading
+    // whitespace included
+    const char prefixed[] = "0x18: b4:+30:0000ff";
+    retval = nl_getCharSeparatedBytes(&prefixed[0], &bytes[0], 4, ':', 16);
+    NL_TEST_ASSERT(inSuite, retval == 4);
+    NL_TEST_ASSERT(inSuite, bytes[0] == 0x18);
+    NL_TEST_ASSERT(inSuite, bytes[1] == 0xb4);
+    NL_TEST_ASSERT(inSuite, bytes[2] == 0x30);
+    NL_TEST_ASSERT(inSuite, bytes[3] == 0xff);
+
+    const char detected[] = "0x18,010,9";
+    retval = nl_getCharSeparatedBytes(&detected[0], &bytes[0], 3, ',', 0);
+    NL_TEST_ASSERT(inSuite, retval == 3);
+    NL_TEST_ASSERT(inSuite, bytes[0] == 0x18);
+    NL_TEST_ASSERT(inSuite, bytes[1] == 010);
+    NL_TEST_ASSERT(inSuite, bytes[2] == 9);
+
+    // bad. out of range, however many digits
+    const char error5[] = "18:100:30";
+    retval = nl_getCharSeparatedBytes(&error5[0], &bytes[0], 3, ':', 16);
+    NL_TEST_ASSERT(inSuite, retval == 1);
+
+    const char error6[] = "1,99999999999999999999999,3";
+    retval = nl_getCharSeparatedBytes(&error6[0], &bytes[0], 3, ',', 10);
+    NL_TEST_ASSERT(inSuite, retval == 1);
+}
+
+// The implementation of nl_getCharSeparatedBytes before its digit
+// scanning fast path, against which the current one is compared.
+
+static int GetCharSeparatedBytesReference(const char* inBuffer, uint8_t* outBytes, size_t inNumValues, char inSeparator, int inBase)
+{
+    const char* current;
+    const char* next = inBuffer;
+    size_t i;
+    for (i = 0; i < inNumValues; i++)
+    {
+        current = next;
+        unsigned int val = strtoul(current, (char**) &next, inBase);
+        if ((val > 255)
+           ||((i != (inNumValues-1)) && (*next != inSeparator))
+           ||((i == (inNumValues-1)) && (*next != '\0'))
+           ||(next == current))
+        {
+            break;
+        }
+        *outBytes++ = (uint8_t) val;
+        next++;
+    }
+    return i;
+}
+
+static void TestGetCharSeparatedBytesFields(nlTestSuite *inSuite, void *inContext)
+{
+    static const char *fields[] = {
+        "0", "7", "9", "a", "F", "g", "10", "ff", "FF", "fg", "100", "255", "256",
+        "0x1", "0X", "x1", "00000012", " 1", "+2", "-0", "", ":", ",", "1 "
+    };
+    static const int bases[] = { 0, 8, 10, 16 };
+    const size_t numFields = sizeof (fields) / sizeof (fields[0]);
+    char buffer[64];
+    uint8_t bytes[3];
+    uint8_t expected_bytes[3];
+    int expected;
+    int retval;
+    size_t i, j, k;
+
+    // Every pairing of two fields followed by a well-formed one, so
+    // that every field is seen before both a separator and the end.
+
+    for (i = 0; i < sizeof (bases) / sizeof (bases[0]); i++)
+    {
+        for (j = 0; j < numFields; j++)
+        {
+            for (k = 0; k < numFields; k++)
+            {
+                snprintf(buffer, sizeof (buffer), "%s:%s:%s", fields[j], fields[k], "1");
+
+                expected = GetCharSeparatedBytesReference(buffer, expected_bytes, 3, ':', bases[i]);
+                retval = nl_getCharSeparatedBytes(buffer, bytes, 3, ':', bases[i]);
+                NL_TEST_ASSERT(inSuite, retval == expected);
+                NL_TEST_ASSERT(inSuite, memcmp(bytes, expected_bytes, expected) == 0);
+
+                snprintf(buffer, sizeof (buffer), "%s:%s", fields[j], fields[k]);
+
+                expected = GetCharSeparatedBytesReference(buffer, expected_bytes, 2, ':', bases[i]);
+                retval = nl_getCharSeparatedBytes(buffer, bytes, 2, ':', bases[i]);
+                NL_TEST_ASSERT(inSuite, retval == expected);
+                NL_TEST_ASSERT(inSuite, memcmp(bytes, expected_bytes, expected) == 0);
+            }
+        }
+    }
+}
+
+static void TestGetCharSeparatedBytesBatch(nlTestSuite *inSuite, void *inContext)
+{
+    const char *macs[] = {
+        "18:b4:30:00:01:02",
+        "18:b4:30:ca:fe:ba",
+        "18:b4:30;ca:fe:ba",
+        "ff:ff:ff:ff:ff:ff"
+    };
+    uint8_t bytes[4][6];
+    int parsed[4];
+    size_t retval;
+
+    retval = nl_getCharSeparatedBytesBatch(macs, 4, &bytes[0][0], 6, ':', 16, parsed);
+    NL_TEST_ASSERT(inSuite, retval == 3);
+    NL_TEST_ASSERT(inSuite, parsed[0] == 6);
+    NL_TEST_ASSERT(inSuite, parsed[1] == 6);
+    NL_TEST_ASSERT(inSuite, parsed[2] == 2);
+    NL_TEST_ASSERT(inSuite, parsed[3] == 6);
+    NL_TEST_ASSERT(inSuite, bytes[0][5] == 0x02);
+    NL_TEST_ASSERT(inSuite, bytes[1][3] == 0xca);
+    NL_TEST_ASSERT(inSuite, bytes[2][1] == 0xb4);
+    NL_TEST_ASSERT(inSuite, bytes[3][0] == 0xff);
+
+    retval = nl_getCharSeparatedBytesBatch(macs, 2, &bytes[0][0], 6, ':', 16, NULL);
+    NL_TEST_ASSERT(inSuite, retval == 2);
+
+    retval = nl_getCharSeparatedBytesBatch(macs, 0, &bytes[0][0], 6, ':', 16, NULL);
+    NL_TEST_ASSERT(inSuite, retval == 0);
 }
 
 static void TestPrintBytesWithSeparator(nlTestSuite *inSuite, void *inContext)
@@ -153,7 +281,7 @@ static void TestStrHexToBin(nlTestSuite *inSuite, void *inContext)
     const uint8_t expected_bin[22] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf };
     size_t i;
 
-    nl_strhextobin(&bin[0], &hex[0], strlen(hex));
+    nl_strhextobin(&bin[0], &hex[0], strlen(hex) / 2);
 
     for (i = 0; i < 22; i++)
     {
@@ -196,6 +324,51 @@ static void TestIsHexStr(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, result == false);
 }
 
+static void TestIsHexStrN(nlTestSuite *inSuite, void *inContext)
+{
+    const char *passing = "9911f7af049e8aae4971fce8ea3948806919cc49aa58cb14cbdfe6912cf08fdaABCDEF";
+    char buffer[100];
+    size_t expected;
+    size_t result;
+    size_t i;
+    int c;
+
+    result = nl_isxdigitstrn(passing, strlen(passing));
+    NL_TEST_ASSERT(inSuite, result == strlen(passing));
+
+    /* The length bounds the scan; the terminator is never looked at. */
+
+    result = nl_isxdigitstrn(passing, 10);
+    NL_TEST_ASSERT(inSuite, result == 10);
+
+    result = nl_isxdigitstrn(passing, 0);
+    NL_TEST_ASSERT(inSuite, result == 0);
+
+    /* Every character, at every position, classifies as the "C"
+     * locale's isxdigit does.
+     */
+
+    memset(buffer, 'a', sizeof (buffer));
+
+    for (c = 1; c < 256; c++)
+    {
+        expected = (strchr("0123456789abcdefABCDEF", c) != NULL) ? sizeof (buffer) : 0;
+
+        for (i = 0; i < sizeof (buffer); i++)
+        {
+            buffer[i] = (char)c;
+
+            result = nl_isxdigitstrn(buffer, sizeof (buffer));
+            NL_TEST_ASSERT(inSuite, result == (expected ? expected : i));
+
+            buffer[i] = 'a';
+        }
+    }
+
+    result = nl_isxdigitstrn("0a\0b", 4);
+    NL_TEST_ASSERT(inSuite, result == 2);
+}
+
 static void TestMemoryDump(nlTestSuite *inSuite, void *inContext)
 {
     const uint8_t bytes[] = { 0x57, 0xcb, 0xe0, 0x42,
@@ -218,6 +391,252 @@ static void TestMemoryDump(nlTestSuite *inSuite, void *inContext)
     nl_dump_bytes((uintptr_t)&bytes[0], &bytes[0], sizeof (bytes) / sizeof(bytes[0]));
 }
 
+// The printf-based implementation of nl_dump_bytes, formatting into a
+// buffer, against which the current one is compared.
+
+static size_t DumpBytesReference(char *outBuffer, uintptr_t offs, const uint8_t *bytes, size_t num)
+{
+    char *d = outBuffer;
+    size_t i;
+
+    while (num > 0)
+    {
+        const size_t thisGo = (num >= 16 ? 16 : num);
+
+        d += sprintf(d, "%08" PRIXPTR "  ", offs);
+
+        for (i = 0; i < thisGo; i++)
+        {
+            d += sprintf(d, "%.02" PRIX8 " ", bytes[i]);
+
+            if ((i & 3) == 3)
+                d += sprintf(d, " ");
+            if (i == 7)
+                d += sprintf(d, " ");
+        }
+
+        for (i = 0; i < thisGo; i++)
+            *d++ = isprint(bytes[i]) ? bytes[i] : '.';
+
+        *d++ = '\n';
+
+        num -= thisGo;
+        offs += thisGo;
+        bytes += thisGo;
+    }
+
+    *d = '\0';
+
+    return (size_t)(d - outBuffer);
+}
+
+static void DumpBytesAppend(const char *inChars, size_t inLen, void *inContext)
+{
+    char *buffer = (char *)inContext;
+
+    strncat(buffer, inChars, inLen);
+}
+
+static void TestMemoryDumpFormat(nlTestSuite *inSuite, void *inContext)
+{
+    static const uintptr_t offsets[] = { 0, 0x1234, 0xfffffff8, (uintptr_t)-40 };
+    static uint8_t bytes[1100];
+    static char expected[sizeof (bytes) * 6];
+    static char buffer[sizeof (bytes) * 6];
+    size_t expected_len;
+    size_t len;
+    size_t size;
+    size_t i;
+    int n;
+
+    for (i = 0; i < sizeof (bytes); i++)
+        bytes[i] = (uint8_t)i;
+
+    // Every length of a few lines, and some several batches long, at
+    // offsets that need more than 8 digits part way through.
+
+    for (i = 0; i < sizeof (offsets) / sizeof (offsets[0]); i++)
+    {
+        for (size = 0; size <= sizeof (bytes); size += (size < 80) ? 1 : 97)
+        {
+            expected_len = DumpBytesReference(expected, offsets[i], &bytes[sizeof (bytes) - size], size);
+
+            len = nl_dump_bytes_buffer(buffer, sizeof (buffer), offsets[i], &bytes[sizeof (bytes) - size], size);
+            NL_TEST_ASSERT(inSuite, len == expected_len);
+            n = strcmp(buffer, expected);
+            NL_TEST_ASSERT(inSuite, n == 0);
+
+            buffer[0] = '\0';
+            nl_dump_bytes_write(offsets[i], &bytes[sizeof (bytes) - size], size, DumpBytesAppend, buffer);
+            n = strcmp(buffer, expected);
+            NL_TEST_ASSERT(inSuite, n == 0);
+        }
+    }
+
+    // A short buffer is filled, terminated and the full length returned.
+
+    expected_len = DumpBytesReference(expected, 0, bytes, 40);
+
+    len = nl_dump_bytes_buffer(buffer, 10, 0, bytes, 40);
+    NL_TEST_ASSERT(inSuite, len == expected_len);
+    n = strncmp(buffer, expected, 9);
+    NL_TEST_ASSERT(inSuite, n == 0 && buffer[9] == '\0');
+
+    len = nl_dump_bytes_buffer(NULL, 0, 0, bytes, 40);
+    NL_TEST_ASSERT(inSuite, len == expected_len);
+}
+
+static void TestMemoryDumpSqueeze(nlTestSuite *inSuite, void *inContext)
+{
+    static const char expected[] =
+        "00001000  00 00 00 00  00 00 00 00   00 00 00 00  00 00 00 00  ................\n"
+        "*\n"
+        "00001040  00 00 00 00  00 00 00 00   00 00 00 00  00 00 00 41  ...............A\n"
+        "00001050  00 00 00 00  00 00 00 00   00 00 00 00  00 00 00 00  ................\n"
+        "*\n"
+        "00001070  00 00 00 00  00 00 00 00   ........\n";
+    uint8_t bytes[0x78];
+    char buffer[sizeof (expected) * 2];
+    char unsqueezed[sizeof (bytes) * 6];
+    char buffer2[sizeof (bytes) * 6];
+    int n;
+
+    memset(bytes, 0, sizeof (bytes));
+    bytes[0x4f] = 'A';
+
+    buffer[0] = '\0';
+    nl_dump_bytes_flags(0x1000, bytes, sizeof (bytes), NLDUMPBYTES_FLAG_SQUEEZE, DumpBytesAppend, buffer);
+    n = strcmp(buffer, expected);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    // Without the flag, nothing is squeezed.
+
+    DumpBytesReference(unsqueezed, 0x1000, bytes, sizeof (bytes));
+
+    buffer2[0] = '\0';
+    nl_dump_bytes_flags(0x1000, bytes, sizeof (bytes), 0, DumpBytesAppend, buffer2);
+    n = strcmp(buffer2, unsqueezed);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    // Nor is a single line.
+
+    buffer[0] = '\0';
+    nl_dump_bytes_flags(0x1000, bytes, 0x10, NLDUMPBYTES_FLAG_SQUEEZE, DumpBytesAppend, buffer);
+    n = strncmp(buffer, expected, strlen(buffer));
+    NL_TEST_ASSERT(inSuite, n == 0 && strlen(buffer) == 80);
+
+    // One that ends in a run closes with the offset past its end.
+
+    buffer[0] = '\0';
+    nl_dump_bytes_flags(0x1000, bytes, 0x40, NLDUMPBYTES_FLAG_SQUEEZE, DumpBytesAppend, buffer);
+    n = strncmp(buffer, expected, 82);
+    NL_TEST_ASSERT(inSuite, n == 0 && strcmp(&buffer[82], "00001040\n") == 0);
+}
+
+static void TestMemoryDumpDiff(nlTestSuite *inSuite, void *inContext)
+{
+    static const char expected[] =
+        "-00000010  00 00 00 00  00 00 00 00   00 00 00 00  00 00 00 00  ................\n"
+        "+00000010  00 00 00 00  00 00 00 00   00 00 00 00  00 FF 00 00  ................\n"
+        "-00000050  00 00 00 ...\n"
+        "+00000050  00 00 2A ..*\n";
+    uint8_t before[0x53];
+    uint8_t after[sizeof (before)];
+    char buffer[sizeof (expected) * 2];
+    int n;
+
+    memset(before, 0, sizeof (before));
+    memcpy(after, before, sizeof (after));
+    after[0x1d] = 0xff;
+    after[0x52] = '*';
+
+    buffer[0] = '\0';
+    nl_dump_bytes_diff(0, before, after, sizeof (before), DumpBytesAppend, buffer);
+    n = strcmp(buffer, expected);
+    NL_TEST_ASSERT(inSuite, n == 0);
+
+    // Identical snapshots produce no output at all.
+
+    buffer[0] = '\0';
+    nl_dump_bytes_diff(0, before, before, sizeof (before), DumpBytesAppend, buffer);
+    NL_TEST_ASSERT(inSuite, buffer[0] == '\0');
+}
+
+typedef struct {
+    char   *buffer;
+    size_t  len;
+} DumpBytesOutput;
+
+static void DumpBytesCollect(const char *inChars, size_t inLen, void *inContext)
+{
+    DumpBytesOutput *output = (DumpBytesOutput *)inContext;
+
+    memcpy(&output->buffer[output->len], inChars, inLen);
+    output->len += inLen;
+}
+
+static void TestMemoryDumpFileParallel(nlTestSuite *inSuite, void *inContext)
+{
+    static const size_t tasks[] = { 0, 1, 3, 8 };
+    static const uint8_t flags[] = { 0, NLDUMPBYTES_FLAG_SQUEEZE };
+    const size_t size = (1 << 20) + 1234;
+    uint8_t *bytes = (uint8_t *)malloc(size);
+    DumpBytesOutput expected;
+    DumpBytesOutput output;
+    FILE *file = tmpfile();
+    size_t i, j;
+    int retval;
+
+    NL_TEST_ASSERT(inSuite, bytes != NULL && file != NULL);
+
+    if (bytes == NULL || file == NULL)
+        return;
+
+    expected.buffer = (char *)malloc(size * 6);
+    output.buffer = (char *)malloc(size * 6);
+
+    // Runs of zeros, of repeated lines, start and end all over, across
+    // the boundaries of the slices the dump is formatted in, with
+    // changing bytes elsewhere. The last run goes on past the end,
+    // so the dump ends squeezed.
+
+    for (i = 0; i < size; i++)
+        bytes[i] = ((i / 4096) % 7 < 4 || i >= size - 100000) ? 0 :
+            ((i / 16) % 5 == 0) ? (uint8_t)(i % 16) : (uint8_t)(i * 131 + (i >> 8));
+
+    NL_TEST_ASSERT(inSuite, fwrite(bytes, 1, size, file) == size);
+    fflush(file);
+
+    for (i = 0; i < sizeof (flags) / sizeof (flags[0]); i++)
+    {
+        expected.len = 0;
+        nl_dump_bytes_flags(0x10000, bytes, size, flags[i], DumpBytesCollect, &expected);
+
+        for (j = 0; j < sizeof (tasks) / sizeof (tasks[0]); j++)
+        {
+            output.len = 0;
+            retval = nl_dump_file_parallel(fileno(file), 0x10000, flags[i], tasks[j], DumpBytesCollect, &output);
+
+            // Without memory mapping, nothing is dumped.
+
+            if (retval != 0 && errno == ENOSYS)
+            {
+                NL_TEST_ASSERT(inSuite, output.len == 0);
+                continue;
+            }
+
+            NL_TEST_ASSERT(inSuite, retval == 0);
+            NL_TEST_ASSERT(inSuite, output.len == expected.len);
+            NL_TEST_ASSERT(inSuite, memcmp(output.buffer, expected.buffer, expected.len) == 0);
+        }
+    }
+
+    fclose(file);
+    free(output.buffer);
+    free(expected.buffer);
+    free(bytes);
+}
+
 static void TestStrnCpyPrettyPrint(nlTestSuite *inSuite, void *inContext)
 {
     char input1[17] = { 0x62, 0x1a, 0x48, 0xea, 0x1c, 0x9a, 0xe8, 0x78, 0xa6, 0x43, 0x5a, 0x2f, 0x38, 0x66, 0x57, 0x4e, 0x00 };
@@ -254,12 +673,19 @@ static void TestStrnCpyPrettyPrint(nlTestSuite *inSuite, void *inContext)
 
 static const nlTest sTests[] = {
     NL_TEST_DEF("parsing delimited byte strings",             TestGetCharSeparatedBytes),
+    NL_TEST_DEF("parsing delimited byte string fields",       TestGetCharSeparatedBytesFields),
+    NL_TEST_DEF("parsing batches of delimited byte strings",  TestGetCharSeparatedBytesBatch),
     NL_TEST_DEF("printing delimited byte strings",            TestPrintBytesWithSeparator),
     NL_TEST_DEF("character hexadecimal to binary conversion", TestHexToBin),
     NL_TEST_DEF("string hexadecimal to binary conversion",    TestStrHexToBin),
     NL_TEST_DEF("binary to hexadecimal string conversion",    TestBinToHexStr),
     NL_TEST_DEF("hexadecimal string introspection",           TestIsHexStr),
+    NL_TEST_DEF("bounded hexadecimal string introspection",   TestIsHexStrN),
     NL_TEST_DEF("memory dump",                                TestMemoryDump),
+    NL_TEST_DEF("memory dump format",                         TestMemoryDumpFormat),
+    NL_TEST_DEF("memory dump squeezing",                      TestMemoryDumpSqueeze),
+    NL_TEST_DEF("memory dump differences",                    TestMemoryDumpDiff),
+    NL_TEST_DEF("parallel file memory dump",                  TestMemoryDumpFileParallel),
     NL_TEST_DEF("pretty printing string copy",                TestStrnCpyPrettyPrint),
     NL_TEST_SENTINEL()
 };